@@ -1,11 +1,25 @@
 #pragma once
+#include <vector>
+#include "Logger.hpp"
 
 namespace Client {
 	void Connect(const std::string, const std::string, const std::string);
 	void SendCheck(int64_t);
+	// Returns false if there's no connection to scout over, meaning no reply is coming.
+	bool ScoutLocations(const std::vector<int64_t>&);
 	void Say(std::string);
 	void PollServer();
 	void CompleteGame();
 	void SendDeathLink();
 	void Disconnect();
+	// Stops every thread the client started. Only called when the mod is unloaded.
+	void Shutdown();
+	void ToggleNetworkThread();
+	void SetHeartbeat(int, int);
+	// DeathLinks older than this many seconds are ignored, or none are if it's 0.
+	void SetDeathLinkMaxAge(int);
+	void ToggleRecording();
+	void Replay(const std::string, bool);
+	// Prints stats from NetStats and every module the client drives.
+	void PrintStats(LogType);
 }
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#include <chrono>
+#include "Logger.hpp"
+
+namespace ClockSync {
+	struct Estimate {
+		bool synced;
+		// Seconds to add to our wall clock to get the server's.
+		double offset_seconds;
+		std::chrono::microseconds min_round_trip;
+		std::chrono::microseconds jitter;
+	};
+
+	// Anchors the estimate to the server time that came with room info, taken as it arrives.
+	void OnRoomInfo(double);
+
+	// Refines the estimate with a ping's round trip time.
+	void OnRoundTrip(std::chrono::microseconds);
+
+	// Returns our best guess at the server's current Unix time in seconds.
+	double ServerNow();
+
+	Estimate GetEstimate();
+	void PrintStats(LogType);
+	void Reset();
+}
\ No newline at end of file
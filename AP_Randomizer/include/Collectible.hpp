@@ -1,5 +1,6 @@
 #pragma once
 #include "Unreal/UnrealCoreStructs.hpp"
+#include "Options.hpp"
 
 namespace GameData {
 	using RC::Unreal::FVector;
@@ -11,7 +12,7 @@ namespace GameData {
 			checked = false;
 		}
 
-		Collectible(FVector new_position, std::vector<std::pair<std::string, int>> new_options) {
+		Collectible(FVector new_position, std::vector<std::pair<bool Options::*, bool>> new_options) {
 			position = new_position;
 			required_options = new_options;
 			checked = false;
@@ -28,9 +29,9 @@ namespace GameData {
 		FVector GetPosition() const {
 			return position;}
 
-		bool CanCreate(std::unordered_map<std::string, int> option_set) const {
-			for (const auto& [option_name, option_value] : required_options) {
-				if (option_set.at(option_name) != option_value) {
+		bool CanCreate(const Options& option_set) const {
+			for (const auto& [option, option_value] : required_options) {
+				if (option_set.*option != option_value) {
 					return false;
 				}
 			}
@@ -41,6 +42,6 @@ namespace GameData {
 	private:
 		FVector position;
 		bool checked;
-		std::vector<std::pair<std::string, int>> required_options;
+		std::vector<std::pair<bool Options::*, bool>> required_options;
 	};
 }
\ No newline at end of file
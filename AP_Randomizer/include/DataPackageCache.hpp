@@ -0,0 +1,23 @@
+#pragma once
+#include "nlohmann/json.hpp"
+
+namespace DataPackageCache {
+	// Returns a stand-in for every cached game in the same shape as a DataPackage command's data, or null if nothing is cached.
+	// Each stand-in only carries its checksum and empty name tables, which is all the client needs to skip fetching it;
+	// the names themselves are read with LoadGame once something actually needs them.
+	nlohmann::json LoadChecksums();
+
+	enum class LoadResult {
+		Loaded,
+		NotCached,
+		// The game was in the index, so the client was handed a stand-in for it and won't fetch it by itself.
+		// Its index entry is dropped so later connections fetch it normally.
+		Unreadable,
+	};
+
+	// Reads one game's cached package.
+	LoadResult LoadGame(const std::string&, nlohmann::json&);
+
+	// Writes any games from a received data package that aren't cached yet under their checksum.
+	void Save(const nlohmann::json&);
+}
\ No newline at end of file
@@ -52,7 +52,7 @@ namespace DeathLinkMessages {
 		/*
 		using std::begin, std::end;
 		std::vector<std::wstring> own_messages(own_deathlink_messages);
-		if (GameData::GetOptions().at("logic_level") > 1) {
+		if (GameData::GetOptions().logic_level > 1) {
 			own_messages.insert(end(own_messages), begin(high_logic_messages), end(high_logic_messages));
 		}
 		*/
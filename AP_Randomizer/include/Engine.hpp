@@ -1,15 +1,70 @@
 #pragma once
-#include <variant>
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <utility>
 #include "Unreal/UObject.hpp"
 #include "GameData.hpp"
+#include "Logger.hpp"
 
 namespace Engine {
 	using RC::Unreal::UObject;
 
-	void ExecuteBlueprintFunction(std::variant<std::wstring, UObject*>, std::wstring, std::shared_ptr<void>);
+	// Every blueprint function the mod calls. Engine.cpp maps each one to the blueprint it lives on and its name.
+	enum class BlueprintFunction {
+		PrintToConsole,
+		PrintMessage,
+		SetHealthPieces,
+		SetSmallKeys,
+		SetMajorKeys,
+		SetUpgrades,
+		SpawnCollectible,
+		CombatDeath,
+		Despawn,
+		Count
+	};
+
+	// Blueprint calls run in this order, each lane draining before the next one starts.
+	enum class CallPriority {
+		Gameplay,
+		Spawn,
+		Interface,
+		Count
+	};
+
+	// Params are stored inline in the call queue, so the biggest params struct has to fit in this.
+	constexpr size_t max_blueprint_params = 64;
+
+	// The type-erased half of CallBlueprintFunction. Use that instead.
+	void QueueBlueprintCall(BlueprintFunction, UObject*, void*, void (*)(void*, void*), void (*)(void*));
+
+	// Queues a blueprint function to run on the next engine tick. Params must be laid out the way the function expects them.
+	// Functions that run on a specific object, like Despawn, take it as the target.
+	template <typename Params>
+	void CallBlueprintFunction(BlueprintFunction function, Params params, UObject* target = nullptr) {
+		static_assert(sizeof(Params) <= max_blueprint_params, "Blueprint params don't fit in a call queue slot");
+		static_assert(alignof(Params) <= 16, "Blueprint params are aligned too strictly for a call queue slot");
+		QueueBlueprintCall(function, target, &params,
+			[](void* destination, void* source) { new (destination) Params(std::move(*static_cast<Params*>(source))); },
+			[](void* stored) { static_cast<Params*>(stored)->~Params(); });
+	}
+	void CallBlueprintFunction(BlueprintFunction, UObject* = nullptr);
+
 	void OnTick(UObject*);
+	// Let Engine cache handles to our blueprints as they appear, instead of searching for them on every call.
+	void OnBeginPlay(UObject*);
+	void OnObjectConstructed(UObject*);
+
+	// Sets how long OnTick may spend running blueprint calls each frame. Zero runs every queued call at once.
+	void SetTickBudget(std::chrono::microseconds);
+
+	// Prints the blueprint call queue and handle cache stats.
+	void PrintStats(LogType);
+
 	void SyncItems();
 	void SpawnCollectibles();
+	// Spawns the current map's collectibles if they were waiting on scouts that have all arrived.
+	void OnScoutsReceived();
 	void DespawnCollectible(const int64_t);
 	GameData::Map GetCurrentMap();
 	void ToggleSlideJump();
@@ -28,11 +28,15 @@ namespace GameData {
 
 	void Initialize();
 	void Close();
+	bool StartSession(std::string);
+	void ResetItems();
+	int GetNextItemIndex();
+	void SetNextItemIndex(int);
 	int GetHealthPieces();
 	int GetSmallKeys();
 	bool* GetMajorKeys();
-	void SetOption(std::string, int);
-	std::unordered_map<std::string, int> GetOptions();
+	void SetOptions(const Options&);
+	const Options& GetOptions();
 	std::unordered_map<std::wstring, int> GetUpgradeTable();
 	std::unordered_map<int64_t, Collectible> GetCollectiblesOfZone(Map);
 	void CheckLocation(const int64_t);
@@ -16,8 +16,10 @@ namespace Logger {
 	void OnTick();
 	void ToggleMessageMute();
 	void ToggleMessageHide();
-	void PrintToConsole(std::wstring, std::wstring);
-	void PrintToConsole(std::wstring);
+	void ToggleVerbose();
+	bool IsVerbose();
+	void PrintToConsole(const std::wstring&, const std::wstring&);
+	void PrintToConsole(const std::wstring&);
 }
 
 // Don't want to have to prefix Logger twice every time we log something
@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "Logger.hpp"
+
+namespace MessageCoalescer {
+	// A run of item sends from one player that were folded instead of printed.
+	struct Summary {
+		int sender;
+		uint64_t folded;
+	};
+
+	struct Stats {
+		uint64_t folded;
+		uint64_t summaries;
+	};
+
+	// Folds an item send that doesn't involve our slot into its sender's current run.
+	// Returns false if it should be printed on its own, which is always the case for the first send of a run.
+	// The time is only passed in by the unit tests, so they can close windows without sleeping.
+	bool Fold(int, std::chrono::steady_clock::time_point = std::chrono::steady_clock::now());
+
+	// Closes every run whose window has passed, or every run if told to, and returns the ones that folded anything.
+	std::vector<Summary> TakeClosedRuns(bool, std::chrono::steady_clock::time_point = std::chrono::steady_clock::now());
+
+	// Zero turns folding off.
+	void SetWindow(std::chrono::milliseconds);
+
+	Stats GetStats();
+	void PrintStats(LogType);
+	void Reset();
+}
\ No newline at end of file
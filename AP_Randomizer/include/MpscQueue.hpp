@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Engine {
+	// Fixed-size ring buffer for handing values from any number of producer threads to exactly one consumer thread.
+	// Each slot carries a sequence number saying whose turn it is, so producers only race each other for the tail index
+	// and never wait on the consumer. Values are built and consumed in place, so nothing is copied in or out.
+	template <typename T, size_t capacity>
+	class MpscQueue {
+		static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "MpscQueue capacity must be a power of two");
+
+	public:
+		MpscQueue() {
+			for (size_t i = 0; i < capacity; i++) {
+				slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		// Any thread. Calls fill(T&) on a free slot, or returns false without calling it if the queue is full.
+		template <typename Fill>
+		bool TryPush(Fill&& fill) {
+			size_t tail = tail_index.load(std::memory_order_relaxed);
+			Slot* slot;
+			while (true) {
+				slot = &slots[tail & (capacity - 1)];
+				size_t sequence = slot->sequence.load(std::memory_order_acquire);
+				if (sequence == tail) {
+					if (tail_index.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				}
+				else if (sequence < tail) {
+					// The consumer hasn't freed this slot since the last lap.
+					return false;
+				}
+				else {
+					tail = tail_index.load(std::memory_order_relaxed);
+				}
+			}
+			fill(slot->value);
+			slot->sequence.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only. Calls consume(T&) on the oldest value, or returns false if the queue is empty.
+		// The slot isn't handed back to producers until consume returns.
+		template <typename Consume>
+		bool TryPop(Consume&& consume) {
+			Slot& slot = slots[head_index & (capacity - 1)];
+			if (slot.sequence.load(std::memory_order_acquire) != head_index + 1) {
+				return false;
+			}
+			consume(slot.value);
+			slot.sequence.store(head_index + capacity, std::memory_order_release);
+			head_index++;
+			return true;
+		}
+
+	private:
+		struct Slot {
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		// Keep the producers' index away from the consumer's so they don't thrash each other's cache line.
+		alignas(64) std::atomic<size_t> tail_index = 0;
+		alignas(64) size_t head_index = 0;
+		std::array<Slot, capacity> slots;
+	};
+}
\ No newline at end of file
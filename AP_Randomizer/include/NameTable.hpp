@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "nlohmann/json.hpp"
+
+namespace NameTable {
+	struct Player {
+		int slot;
+		std::string alias;
+		std::string game;
+	};
+
+	// Interns every item and location name in a data package, replacing any games that were already loaded.
+	// Games with empty name tables are cache stand-ins and are skipped.
+	void LoadDataPackage(const nlohmann::json&);
+
+	void SetPlayers(const std::vector<Player>&);
+
+	// The returned views stay valid until the next call to LoadDataPackage, SetPlayers, or Clear.
+	std::string_view GetPlayerAlias(int);
+	std::string_view GetItemName(int64_t, int);
+	std::string_view GetLocationName(int64_t, int);
+
+	// Returns false if the player's game has no names yet, meaning its package is still on its way from the server.
+	// Games are only read out of the data package cache the first time one of their players is looked up.
+	bool HasNames(int);
+
+	// Returns games whose cached package turned out to be unreadable, each only once.
+	// The client was told they're cached, so they have to be asked for explicitly.
+	std::vector<std::string> TakeGamesToFetch();
+
+	void Clear();
+}
\ No newline at end of file
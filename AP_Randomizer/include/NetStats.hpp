@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "Logger.hpp"
+
+namespace NetStats {
+	// Every server callback the client handles, plus the poll that drives them.
+	enum class Handler {
+		Poll,
+		RoomInfo,
+		SlotConnected,
+		SlotRefused,
+		SocketError,
+		ItemsReceived,
+		LocationChecked,
+		PrintJson,
+		Bounced,
+		DataPackage,
+		RoomUpdate,
+		SetReply,
+		LocationInfo,
+		Count
+	};
+
+	// Every command the client sends.
+	enum class Command {
+		ConnectSlot,
+		ConnectUpdate,
+		LocationChecks,
+		StatusUpdate,
+		Bounce,
+		Say,
+		Set,
+		Sync,
+		Ping,
+		LocationScouts,
+		GetDataPackage,
+		Count
+	};
+
+	void RecordHandler(Handler, std::chrono::nanoseconds);
+	void RecordCommand(Command);
+	void RecordItemPacket(size_t);
+	void RecordRoundTrip(std::chrono::microseconds);
+	// Latency is how long a DeathLink took to reach us from its sender, by the server's clock.
+	void RecordDeathLink(std::chrono::microseconds);
+	void RecordStaleDeathLink();
+	const char* GetCommandName(Command);
+
+	// Prints every counter and histogram. Other modules print their own stats, and Client::PrintStats prints them all.
+	void PrintStats(LogType);
+
+	// Formats a duration with whichever unit keeps it short, for stats lines.
+	std::string FormatMicroseconds(uint64_t);
+
+	// Sets how often stats are dumped to the UE4SS log. Zero disables the periodic dump.
+	void SetDumpInterval(std::chrono::seconds);
+
+	// Returns true once each time the dump interval elapses.
+	bool TakeDumpDue();
+
+	void Reset();
+
+	// Times a handler from construction to destruction.
+	class ScopedTimer {
+	public:
+		explicit ScopedTimer(Handler new_handler) {
+			handler = new_handler;
+			start = std::chrono::steady_clock::now();
+		}
+
+		~ScopedTimer() {
+			RecordHandler(handler, std::chrono::steady_clock::now() - start);
+		}
+
+	private:
+		Handler handler;
+		std::chrono::steady_clock::time_point start;
+	};
+}
\ No newline at end of file
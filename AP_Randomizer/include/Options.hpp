@@ -0,0 +1,14 @@
+#pragma once
+
+namespace GameData {
+	// Slot data options, filled in once per connection after the slot data has been validated.
+	struct Options {
+		int slot_number = 0;
+		bool death_link = false;
+		int logic_level = 1;
+		bool obscure_logic = false;
+		bool progressive_breaker = false;
+		bool progressive_slide = false;
+		bool split_sun_greaves = false;
+	};
+}
\ No newline at end of file
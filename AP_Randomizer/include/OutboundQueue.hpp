@@ -0,0 +1,39 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "Logger.hpp"
+
+namespace OutboundQueue {
+	// Checks and the goal status update skip this queue entirely and always go out first through the Outbox.
+	// Everything else is sent in this order, each class held to its own rate limit.
+	// Game covers DeathLinks, resyncs, scouts, and heartbeat pings, and Storage covers data storage writes like the goal key.
+	enum class Priority {
+		Game,
+		Chat,
+		Storage,
+		Count
+	};
+
+	struct Stats {
+		uint64_t queued;
+		uint64_t sent;
+		uint64_t dropped;
+		size_t depth;
+		size_t max_depth;
+		std::chrono::microseconds max_wait;
+	};
+
+	// Queues a call that needs the APClient. Returns false if the class's queue was full and the call was dropped.
+	// The time is only passed in by the unit tests, so they can refill buckets without sleeping.
+	bool Push(Priority, std::function<void()>, std::chrono::steady_clock::time_point = std::chrono::steady_clock::now());
+
+	// Runs queued calls in priority order until every queue is empty or out of tokens.
+	// Must be called from whichever thread owns the APClient.
+	void Run(std::chrono::steady_clock::time_point = std::chrono::steady_clock::now());
+
+	void Clear();
+
+	Stats GetStats(Priority);
+	void PrintStats(LogType);
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <string>
+#include "Logger.hpp"
+
+namespace Outbox {
+	struct Stats {
+		uint64_t checks_queued;
+		uint64_t duplicates_dropped;
+		// Checks the server already reported as checked, like collectibles picked up again after a reconnect.
+		uint64_t already_checked;
+		uint64_t packets_sent;
+		uint64_t packets_saved;
+		uint64_t bytes_saved;
+	};
+
+	// Loads the on-disk journal for a seed and slot, merging any unsent checks into the outbox.
+	// A journal belonging to a different session is discarded.
+	// Until this is called, anything queued is journaled under whichever session last wrote the journal.
+	void OpenJournal(std::string);
+
+	// Queues a location id to be sent on the next flush. Returns false if the id was a duplicate or the server already had it.
+	bool QueueCheck(int64_t);
+
+	// Marks a location as received by the server so it won't be queued again.
+	void MarkChecked(int64_t);
+
+	bool HasPendingChecks();
+
+	// Removes every pending location id from the outbox so it can be sent as a single packet.
+	std::list<int64_t> TakePendingChecks();
+
+	// Records that the goal was completed. The flag persists until ConfirmGoal is called.
+	void QueueGoal();
+
+	// Returns true once if the goal needs to be sent since the last connection.
+	bool TakeGoal();
+
+	void ConfirmGoal();
+
+	// Requeues checks that were sent but never acknowledged, since they may have been lost with the socket.
+	void OnConnect();
+
+	// Drops the in-memory outbox and closes the journal. The journal file itself is kept for the next connection.
+	void Reset();
+
+	Stats GetStats();
+	void PrintStats(LogType);
+}
\ No newline at end of file
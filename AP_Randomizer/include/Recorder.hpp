@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "nlohmann/json.hpp"
+
+namespace Recorder {
+	enum class Direction : uint8_t {
+		Inbound,
+		Outbound,
+	};
+
+	struct Frame {
+		int64_t time_us;
+		Direction direction;
+		std::string kind;
+		nlohmann::json payload;
+	};
+
+	// Opens a new recording in the recordings folder. Frame times are measured from this call.
+	void Start();
+	void Stop();
+	bool IsRecording();
+	void Record(Direction, std::string_view, const nlohmann::json&);
+
+	// Reads a whole recording, looking in the recordings folder if the path doesn't exist as given.
+	bool Load(const std::string&, std::vector<Frame>&);
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace ScoutCache {
+	// What a LocationScouts reply told us about one of our locations.
+	// Names are resolved once the receiver's game names are loaded, so the game thread never has to touch the name table.
+	struct ScoutedItem {
+		int64_t location;
+		int64_t item;
+		int player;
+		unsigned flags;
+		std::string item_name;
+		std::string player_alias;
+	};
+
+	// Returns the locations that haven't been scouted or requested yet this session, and marks them as requested.
+	std::vector<int64_t> TakeUnscouted(const std::vector<int64_t>&);
+
+	void Store(const std::vector<ScoutedItem>&);
+	std::optional<ScoutedItem> Find(int64_t);
+
+	// Forgets outstanding requests without throwing away anything already scouted, so a reconnect asks again.
+	void ForgetRequests();
+	void Clear();
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+#include "nlohmann/json.hpp"
+#include "Options.hpp"
+
+namespace SlotData {
+	// Validates slot data against the declared schema and fills in the typed options.
+	// Returns false if validation failed, in which case options are filled in as well as possible.
+	bool Parse(const nlohmann::json&, GameData::Options&);
+}
\ No newline at end of file
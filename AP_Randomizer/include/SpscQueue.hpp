@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Client {
+	// Fixed-size ring buffer for handing values from exactly one producer thread to exactly one consumer thread.
+	// Neither side ever takes a lock; a full queue simply refuses the push and lets the producer decide what to do.
+	template <typename T, size_t capacity>
+	class SpscQueue {
+		static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+	public:
+		// Producer only.
+		bool TryPush(T&& value) {
+			const size_t tail = tail_index.load(std::memory_order_relaxed);
+			if (tail - head_index.load(std::memory_order_acquire) == capacity) {
+				return false;
+			}
+			slots[tail & (capacity - 1)] = std::move(value);
+			tail_index.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only.
+		bool TryPop(T& out) {
+			const size_t head = head_index.load(std::memory_order_relaxed);
+			if (head == tail_index.load(std::memory_order_acquire)) {
+				return false;
+			}
+			out = std::move(slots[head & (capacity - 1)]);
+			head_index.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Approximate when called while the other side is active.
+		size_t Size() const {
+			return tail_index.load(std::memory_order_acquire) - head_index.load(std::memory_order_acquire);
+		}
+
+	private:
+		// Keep the two indices on separate cache lines so the threads don't thrash each other.
+		alignas(64) std::atomic<size_t> head_index = 0;
+		alignas(64) std::atomic<size_t> tail_index = 0;
+		std::array<T, capacity> slots;
+	};
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 
 namespace StringOps {
 	// Converts UTF-16 inputs to UTF-8 strings using std::codecvt.
@@ -7,6 +8,11 @@ namespace StringOps {
 
 	// Converts UTF-8 inputs to UTF-16 wide strings using std::codecvt.
 	std::wstring ToWide(std::string);
+
+	// Transcodes UTF-8 input onto the end of an existing UTF-16 string without any temporary strings.
+	// Malformed sequences, including overlong encodings, encoded surrogates, and code points past U+10FFFF,
+	// are replaced with U+FFFD instead of throwing.
+	void AppendWide(std::wstring&, std::string_view);
 	
 	// Hashes std::wstrings for executing switch statements on them.
 	constexpr size_t HashWstring(const std::wstring& to_hash) {
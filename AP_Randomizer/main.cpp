@@ -40,6 +40,8 @@ public:
 
     ~AP_Randomizer()
     {
+        // A joinable network thread at exit would terminate the game.
+        Client::Shutdown();
     }
 
     auto on_unreal_init() -> void override {
@@ -80,6 +82,7 @@ public:
             });
 
         Hook::RegisterBeginPlayPostCallback([&](AActor* actor) {
+            Engine::OnBeginPlay(actor);
             // TODO: Consider moving some of this function out of main
             auto returncheck = [](UnrealScriptFunctionCallableContext& context, void* customdata) {
                 Client::SendCheck(context.GetParams<int64_t>());
@@ -148,6 +151,7 @@ public:
             });
 
         Hook::RegisterStaticConstructObjectPostCallback([&](const FStaticConstructObjectParameters& params, UObject* object) -> UObject* {
+            Engine::OnObjectConstructed(object);
             // Copies text in highlighted message to clipboard.
             auto copytext = [&](UnrealScriptFunctionCallableContext& context, void* customdata) {
                 std::wstring wide(context.GetParams<FText>().ToString());
@@ -4,6 +4,14 @@
 #pragma warning(disable: 4996) // Disable deprecated warnings from old asio version and apclientpp
 #pragma warning(disable: 26495) // Disable uninitialized warnings from asio, websocketpp, and apclientpp
 #pragma warning(disable: 26439) // Disable noexcept warnings from asio
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <variant>
+#include <charconv>
+#include <condition_variable>
+#include <deque>
+#include <optional>
 
 // Boost is included, but not defining asio standalone results in a ton of errors in match_flags.hpp and wswrap_websocketpp.hpp.
 #define ASIO_STANDALONE
@@ -19,10 +27,23 @@
 #include "Timer.hpp"
 #include "DeathLinkMessages.hpp"
 #include "StringOps.hpp"
+#include "Outbox.hpp"
+#include "SpscQueue.hpp"
+#include "DataPackageCache.hpp"
+#include "NameTable.hpp"
+#include "SlotData.hpp"
+#include "NetStats.hpp"
+#include "Recorder.hpp"
+#include "OutboundQueue.hpp"
+#include "ScoutCache.hpp"
+#include "ClockSync.hpp"
+#include "MessageCoalescer.hpp"
 
 namespace Client {
     using std::string;
     using std::list;
+    using std::mutex;
+    using std::lock_guard;
 
     namespace Hashes {
         using StringOps::HashNstring;
@@ -35,76 +56,617 @@ namespace Client {
     namespace {
         typedef nlohmann::json json;
         typedef APClient::State ConnectionStatus;
+
+        // Everything the handlers learn from the server is packed into one of these events.
+        // Whichever thread owns the APClient produces them, and the mod update loop applies them to the game.
+        struct RoomInfoEvent {
+            string session;
+        };
+        struct SlotConnectedEvent {
+            GameData::Options options;
+        };
+        struct ItemsReceivedEvent {
+            list<APClient::NetworkItem> items;
+        };
+        struct LocationsCheckedEvent {
+            list<int64_t> location_ids;
+        };
+        struct PrintEvent {
+            std::wstring markdown_text;
+            std::wstring plain_text;
+            bool is_item_send;
+        };
+        // Only the fields we actually read out of a DeathLink bounce.
+        struct DeathLinkEvent {
+            bool has_details;
+            double time;
+            string source;
+            string cause;
+        };
+        struct LogEvent {
+            string text;
+            LogType type;
+        };
+        struct ScoutsEvent {
+            std::vector<ScoutCache::ScoutedItem> items;
+        };
+        typedef std::variant<RoomInfoEvent, SlotConnectedEvent, ItemsReceivedEvent, LocationsCheckedEvent, PrintEvent, DeathLinkEvent, LogEvent, ScoutsEvent> ClientEvent;
+
+        void Dispatch(ClientEvent&&);
+        void DrainEvents();
+        void HandleEvent(RoomInfoEvent&);
+        void HandleEvent(SlotConnectedEvent&);
+        void HandleEvent(ItemsReceivedEvent&);
+        void HandleEvent(LocationsCheckedEvent&);
+        void HandleEvent(PrintEvent&);
+        void HandleEvent(DeathLinkEvent&);
+        void HandleEvent(LogEvent&);
+        void HandleEvent(ScoutsEvent&);
+        void Post(OutboundQueue::Priority, std::function<void()>);
+        void FlushOutbox();
+        void Heartbeat();
+        void RunOutboundQueue();
+        void StartNetworkThread();
+        void StopNetworkThread();
+        void ApplyRequest();
+        void StartReplay(std::vector<Recorder::Frame>&&, bool);
+        void OpenConnection(const string, const string, const string);
+        void CloseConnection();
+        void DetachClients();
+        void AdoptClients();
+        void RunOnLifecycleThread(std::function<void()>);
+        bool IsLifecycleThreadIdle();
+        void StopLifecycleThread();
+        void LifecycleThreadLoop();
+        void BuildClients(const string, const string, const string, uint64_t);
+        void DestroyClients(APClient*, APClient*);
+        APClient* BuildClient(const string&, const json&);
+        void BindHandlers(APClient*, const string, const string);
+        void PollClients();
+        void ReceiveRoomInfo(APClient*, const string&, const string&);
+        bool SecureSideGaveUp();
+        void ClaimRace(APClient*);
+        void NetworkThreadLoop();
         void ReceiveItems(const list<APClient::NetworkItem>&);
-        string ProcessMessageText(const APClient::PrintJSONArgs&);
-        void ReceiveDeathLink(const json&);
+        void ReceiveMessage(const list<APClient::TextNode>&, bool);
+        void DispatchMessage(const list<APClient::TextNode>&, bool);
+        bool HasNamesFor(const list<APClient::TextNode>&);
+        void RenderPendingMessages(bool);
+        void PrintSummaries(bool);
+        void RenderMessage(const list<APClient::TextNode>&, std::wstring&, std::wstring&);
+        GameData::Options ReadSlotData(const json&);
+        void ReceiveLocationChecks(const list<int64_t>&);
+        void ReceiveScouts(const list<APClient::NetworkItem>&);
+        void ResolvePendingScouts(bool);
+        void RefreshPlayers();
+        void FetchUnreadableGames();
+        template <typename T> T ParseId(const string&);
+        void DecodeBounce(const json&);
+        void ReceivePing(const json&);
+        void SendPing();
+        void ResetDeadConnection();
+        void RecordSend(NetStats::Command, const json& = nullptr);
+        void StopReplay();
+        void StepReplay();
+        bool IsWellFormed(const Recorder::Frame&);
+        void ReplayFrame(const Recorder::Frame&);
+        void ReceiveDeathLink(const DeathLinkEvent&);
+        void SendGoal();
+        string GoalKey();
 
-        // I don't think a mutex is required here because apclientpp locks the instance during poll().
-        // If people report random crashes, especially when disconnecting, I'll revisit it.
+        // Only one thread touches ap at a time: the mod update loop normally, or the network thread while it's running.
+        // Other threads must go through Post() instead of calling into ap directly, and check connection_state instead of ap
+        // to see whether there's a client at all, since the network thread swaps ap when a connection race is claimed.
+        // Connecting and disconnecting are requests the update loop applies, so it's the only thread that ever takes ap away
+        // from the network thread, drains event_queue, or hands old clients to the lifecycle thread.
         APClient* ap;
+        // The plain ws:// side of a connection race, which only starts polling once the stagger has passed.
+        // It can't take the connection until the secure side has failed or timed out, or a slow TLS handshake would be enough
+        // to send the slot password in the clear. Until then, its room info waits in held_room_info.
+        APClient* racing_client;
+        std::chrono::steady_clock::time_point race_start;
+        const std::chrono::milliseconds race_stagger(250);
+        const std::chrono::seconds race_timeout(5);
+        bool secure_failed;
+        std::function<void()> held_room_info;
+
+        // Building and tearing down clients involves sockets, DNS, and certificates, so it happens on the lifecycle thread.
+        // The update loop only ever sees connection_state and, once a build is done, the finished clients.
+        // Disconnected -> Building once a connect request is applied, Building -> Active when PollServer adopts the clients,
+        // and anything -> Disconnected once a disconnect request is applied.
+        enum class ConnectionState {
+            Disconnected,
+            Building,
+            Active,
+        };
+        // Read from the game thread, the update loop, and the network thread. Active whenever ap is set.
+        std::atomic<ConnectionState> connection_state = ConnectionState::Disconnected;
+        struct BuiltClients {
+            APClient* client;
+            APClient* racer;
+        };
+        std::thread lifecycle_thread;
+        bool lifecycle_stopping = false;
+        mutex lifecycle_mutex;
+        std::condition_variable lifecycle_condition;
+        std::deque<std::function<void()>> lifecycle_jobs;
+        bool lifecycle_busy = false;
+        // Bumped by every Connect and Disconnect so that a build that was overtaken knows to throw its clients away.
+        uint64_t connect_generation = 0;
+        std::optional<BuiltClients> built_client;
+        // Connect and Disconnect are called from the game thread while the update loop may be polling ap or draining events,
+        // so they only leave a request here for PollServer to apply. A newer request replaces one that hasn't been applied yet.
+        struct ConnectionRequest {
+            bool connect;
+            string uri;
+            string slot_name;
+            string password;
+        };
+        mutex request_mutex;
+        std::optional<ConnectionRequest> pending_request;
+        // Replays are requested the same way. The recording is read on the game thread and handed over whole.
+        struct ReplayRequest {
+            std::vector<Recorder::Frame> frames;
+            bool real_time;
+        };
+        std::optional<ReplayRequest> pending_replay;
         const string game_name("Pseudoregalia");
         const string uuid(ap_get_uuid("Mods/AP_Randomizer/dlls/uuid"));
+        // wswrap builds a new SSL context and re-parses this bundle for every socket it opens, and apclientpp opens a new socket
+        // on every reconnect. Neither library has a hook for handing in a shared context or a saved TLS session.
         const string cert_store("Mods/AP_Randomizer/dlls/cacert.pem");
         const int max_connection_retries = 3;
         int connection_retries = 0;
         bool death_link_locked;
         const float death_link_timer_seconds(4.0f);
+        // DeathLinks older than this by the server's clock are dropped instead of killing the player, unless it's 0.
+        // Their timestamps come from the sender's clock, so this is generous enough to absorb a fair bit of skew.
+        std::atomic<int> death_link_max_age_seconds = 60;
+
+        // The network thread is opt-in and only takes effect on the next connection.
+        bool use_network_thread = false;
+        std::thread network_thread;
+        std::atomic<bool> network_thread_running = false;
+        const std::chrono::milliseconds network_poll_interval(5);
+        SpscQueue<ClientEvent, 1024> event_queue;
+        // Large PrintJSON bursts are spread out over several updates instead of all landing in one.
+        const std::chrono::microseconds event_budget(2000);
+
+        // Pings are bounces addressed only to our own slot, so the server echoes them straight back to us.
+        const string ping_tag("PseudoregaliaPing");
+        std::chrono::steady_clock::time_point last_ping;
+        // Pings double as a heartbeat. Once too many in a row go unanswered the connection is reset,
+        // rather than waiting for TCP to notice a connection that was silently dropped.
+        // Set from the console, read by whichever thread owns ap.
+        std::atomic<int> heartbeat_seconds = 5;
+        std::atomic<int> heartbeat_missed_limit = 3;
+        int unanswered_pings = 0;
+        std::chrono::steady_clock::time_point last_heartbeat;
+
+        // Messages that name a game whose package hasn't arrived yet wait here instead of rendering as "Unknown".
+        // Everything after a held message waits behind it so the console stays in order. Only touched by whichever thread owns ap.
+        struct PendingMessage {
+            list<APClient::TextNode> nodes;
+            bool is_item_send;
+            std::chrono::steady_clock::time_point received;
+        };
+        std::deque<PendingMessage> pending_messages;
+        const std::chrono::seconds pending_message_timeout(3);
+        const size_t max_pending_messages = 256;
+        // Scout replies wait for names the same way, since they're resolved once and cached for the rest of the session.
+        list<APClient::NetworkItem> pending_scouts;
+        std::chrono::steady_clock::time_point pending_scouts_received;
+
+        // Recording is opt-in like the network thread and starts with the next connection.
+        bool record_sessions = false;
+        // A loaded recording is fed through the handlers from the update loop while disconnected.
+        // Only console output gets applied; events that would change game state are counted in replay_held_events instead.
+        std::vector<Recorder::Frame> replay_frames;
+        size_t replay_position;
+        bool replay_real_time;
+        std::chrono::steady_clock::time_point replay_start;
+        size_t replay_skipped_frames;
+        size_t replay_held_events;
     } // End private members
 
+    // Only leaves a request for the update loop, which applies it on its next PollServer.
     void Client::Connect(const string uri, const string slot_name, const string password) {
-        // Nuke any existing client in case uri needs to change.
-        if (ap != nullptr) {
-            delete ap;
-        }
-        GameData::Initialize();
-        ap = new APClient(uuid, game_name, uri, cert_store);
-        connection_retries = 0;
-        string connect_message(
-            "Attempting to connect to " + uri
-            + " with name " + slot_name + "...");
-        Log(connect_message, LogType::System);
+        lock_guard<mutex> guard(request_mutex);
+        pending_request = ConnectionRequest{ true, uri, slot_name, password };
+    }
+
+    void Client::Disconnect() {
+        lock_guard<mutex> guard(request_mutex);
+        pending_request = ConnectionRequest{ false };
+    }
+
+    // Hands the clients to the lifecycle thread like a disconnect does, then waits for it to tear them down and exit.
+    // The update loop has stopped by the time the mod is unloaded, so this thread can take ap back itself.
+    void Client::Shutdown() {
+        StopReplay();
+        DetachClients();
+        Recorder::Stop();
+        connection_state = ConnectionState::Disconnected;
+        StopLifecycleThread();
+    }
+
+    // Queues a location id to be sent with the rest of this frame's checks.
+    void Client::SendCheck(int64_t id) {
+        if (Outbox::QueueCheck(id)) {
+            Log(L"Queueing check with id " + std::to_wstring(id));
+        }
+    }
+    
+    // Queues the game completion flag to be sent to Archipelago, even if the connection is currently down.
+    void Client::CompleteGame() {
+        Outbox::QueueGoal();
+    }
+
+    void Client::PollServer() {
+        ApplyRequest();
+        if (NetStats::TakeDumpDue()) {
+            PrintStats(LogType::Default);
+        }
+        if (!replay_frames.empty()) {
+            StepReplay();
+            return;
+        }
+        if (connection_state == ConnectionState::Building) {
+            AdoptClients();
+        }
+        if (connection_state != ConnectionState::Active) {
+            return;
+        }
+        if (network_thread_running) {
+            DrainEvents();
+            return;
+        }
+        PollClients();
+        // Checks and the goal go out before anything else that was queued this update.
+        FlushOutbox();
+        Heartbeat();
+        RunOutboundQueue();
+    }
+
+    void Client::ToggleNetworkThread() {
+        use_network_thread = !use_network_thread;
+        if (use_network_thread) {
+            Log(L"The network thread will be used starting with the next connection.", LogType::System);
+        }
+        else {
+            Log(L"The network thread will no longer be used starting with the next connection.", LogType::System);
+        }
+    }
+
+    void Client::SetHeartbeat(int seconds, int missed_limit) {
+        heartbeat_seconds = std::max(seconds, 1);
+        heartbeat_missed_limit = std::max(missed_limit, 0);
+        if (heartbeat_missed_limit == 0) {
+            Log("Heartbeats will be sent every " + std::to_string(heartbeat_seconds.load()) + " seconds, but missed ones will be ignored.", LogType::System);
+        }
+        else {
+            Log("Heartbeats will be sent every " + std::to_string(heartbeat_seconds.load()) + " seconds, and the connection will be reset after "
+                + std::to_string(heartbeat_missed_limit.load()) + " go unanswered.", LogType::System);
+        }
+    }
+
+    void Client::SetDeathLinkMaxAge(int seconds) {
+        death_link_max_age_seconds = std::max(seconds, 0);
+        if (death_link_max_age_seconds == 0) {
+            Log("DeathLinks will be accepted no matter how old they are.", LogType::System);
+        }
+        else {
+            Log("DeathLinks more than " + std::to_string(death_link_max_age_seconds.load()) + " seconds old will be ignored.", LogType::System);
+        }
+    }
+
+    void Client::ToggleRecording() {
+        record_sessions = !record_sessions;
+        if (record_sessions) {
+            Log(L"Sessions will be recorded starting with the next connection.", LogType::System);
+        }
+        else {
+            Log(L"Sessions will no longer be recorded starting with the next connection.", LogType::System);
+        }
+    }
+
+    // Feeds a recorded session back through the handlers, either with its original timing or as fast as possible.
+    // Outbound commands aren't replayed since there's no server to send them to.
+    void Client::Replay(const string path, bool real_time) {
+        std::vector<Recorder::Frame> frames;
+        if (!Recorder::Load(path, frames) || frames.empty()) {
+            return;
+        }
+        lock_guard<mutex> guard(request_mutex);
+        pending_replay = ReplayRequest{ std::move(frames), real_time };
+    }
+
+    void Client::PrintStats(LogType type) {
+        NetStats::PrintStats(type);
+        ClockSync::PrintStats(type);
+        Outbox::PrintStats(type);
+        OutboundQueue::PrintStats(type);
+        MessageCoalescer::PrintStats(type);
+        Engine::PrintStats(type);
+    }
+
+    void Client::SendDeathLink() {
+        using DeathLinkMessages::RandomOutgoingDeathlink;
+        using DeathLinkMessages::RandomOwnDeathlink;
+        if (connection_state != ConnectionState::Active
+        || !GameData::GetOptions().death_link
+        || death_link_locked) {
+            return;
+        }
+
+        string outgoing_message(RandomOutgoingDeathlink());
+        Post(OutboundQueue::Priority::Game, [outgoing_message]() {
+            string funny_message(std::vformat(outgoing_message, std::make_format_args(ap->get_slot())));
+            json data{
+                {"time", ClockSync::ServerNow()},
+                {"cause", funny_message},
+                {"source", ap->get_slot()},
+            };
+            ap->Bounce(data, {}, {}, { "DeathLink" });
+            RecordSend(NetStats::Command::Bounce, data);
+            if (Logger::IsVerbose()) {
+                Log("Sending bounce: " + data.dump());
+            }
+            });
+        Log(RandomOwnDeathlink(), LogType::Popup);
+        Timer::RunTimerInGame(death_link_timer_seconds, &death_link_locked);
+    }
+
+    // Asks the server what a batch of our locations hold, skipping any already scouted or asked about this session.
+    bool Client::ScoutLocations(const std::vector<int64_t>& locations) {
+        if (connection_state != ConnectionState::Active) {
+            return false;
+        }
+        std::vector<int64_t> unscouted = ScoutCache::TakeUnscouted(locations);
+        if (unscouted.empty()) {
+            return true;
+        }
+
+        list<int64_t> batch(unscouted.begin(), unscouted.end());
+        Post(OutboundQueue::Priority::Game, [batch]() {
+            ap->LocationScouts(batch);
+            RecordSend(NetStats::Command::LocationScouts, batch);
+            });
+        Log("Scouting " + std::to_string(batch.size()) + " locations");
+        return true;
+    }
+
+    void Client::Say(string input) {
+        if (connection_state != ConnectionState::Active) {
+            return;
+        }
+
+        Post(OutboundQueue::Priority::Chat, [input]() {
+            ap->Say(input);
+            RecordSend(NetStats::Command::Say, input);
+            });
+    }
+
+
+    // Private functions
+    namespace {
+        // Applies an event immediately when polling inline, or hands it to the update loop from the network thread.
+        void Dispatch(ClientEvent&& event) {
+            // A replay is only there to exercise the pipeline, and must never grant items or checks in whatever save is loaded.
+            if (!replay_frames.empty() && !std::holds_alternative<PrintEvent>(event) && !std::holds_alternative<LogEvent>(event)) {
+                replay_held_events++;
+                return;
+            }
+            if (!network_thread_running) {
+                std::visit([](auto& e) { HandleEvent(e); }, event);
+                return;
+            }
+            // The queue only fills up if the update loop stalls, so just wait for it rather than dropping anything.
+            while (!event_queue.TryPush(std::move(event))) {
+                if (!network_thread_running) {
+                    return;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        // Applies queued events until the queue is empty or this update's budget runs out.
+        void DrainEvents() {
+            auto start = std::chrono::steady_clock::now();
+            ClientEvent event;
+            while (event_queue.TryPop(event)) {
+                std::visit([](auto& e) { HandleEvent(e); }, event);
+                if (std::chrono::steady_clock::now() - start > event_budget) {
+                    break;
+                }
+            }
+        }
+
+        void HandleEvent(RoomInfoEvent& event) {
+            if (!GameData::StartSession(event.session)) {
+                Log("Resuming session from item index " + std::to_string(GameData::GetNextItemIndex()));
+            }
+            else {
+                ScoutCache::Clear();
+            }
+        }
+
+        void HandleEvent(SlotConnectedEvent& event) {
+            GameData::SetOptions(event.options);
+            // Scouts sent over an earlier connection may never have been answered.
+            ScoutCache::ForgetRequests();
+            // Delay spawning collectibles so that we have time to receive checked locations.
+            Timer::RunTimerRealTime(std::chrono::milliseconds(500), Engine::SpawnCollectibles);
+        }
+
+        void HandleEvent(ItemsReceivedEvent& event) {
+            ReceiveItems(event.items);
+        }
+
+        void HandleEvent(LocationsCheckedEvent& event) {
+            for (const auto& id : event.location_ids) {
+                Log(L"Marking location " + std::to_wstring(id) + L" as checked");
+                GameData::CheckLocation(id);
+                Engine::DespawnCollectible(id);
+            }
+        }
+
+        void HandleEvent(PrintEvent& event) {
+            Logger::PrintToConsole(event.markdown_text, event.plain_text);
+
+            if (event.is_item_send) {
+                Log(event.plain_text, LogType::Popup);
+            }
+            else {
+                Log(event.plain_text, LogType::Console);
+            }
+        }
+
+        void HandleEvent(DeathLinkEvent& event) {
+            ReceiveDeathLink(event);
+        }
+
+        void HandleEvent(LogEvent& event) {
+            Log(event.text, event.type);
+        }
+
+        void HandleEvent(ScoutsEvent& event) {
+            ScoutCache::Store(event.items);
+            Engine::OnScoutsReceived();
+        }
+
+        // Queues a call that needs ap so that it runs on whichever thread currently owns it.
+        void Post(OutboundQueue::Priority priority, std::function<void()> call) {
+            OutboundQueue::Push(priority, std::move(call));
+        }
+
+        // Sends everything collected since the last poll as one packet.
+        void FlushOutbox() {
+            if (ap->get_state() != ConnectionStatus::SLOT_CONNECTED) {
+                return;
+            }
+            if (Outbox::HasPendingChecks()) {
+                list<int64_t> checks = Outbox::TakePendingChecks();
+                ap->LocationChecks(checks);
+                RecordSend(NetStats::Command::LocationChecks, checks);
+            }
+            if (Outbox::TakeGoal()) {
+                SendGoal();
+            }
+        }
+
+        // Sends a ping once the heartbeat interval has passed, or resets the connection if too many have gone unanswered.
+        void Heartbeat() {
+            if (ap->get_state() != ConnectionStatus::SLOT_CONNECTED) {
+                return;
+            }
+            if (std::chrono::steady_clock::now() - last_ping < std::chrono::seconds(heartbeat_seconds.load())) {
+                return;
+            }
+            if (heartbeat_missed_limit > 0 && unanswered_pings >= heartbeat_missed_limit) {
+                ResetDeadConnection();
+                return;
+            }
+            SendPing();
+        }
+
+        // Queued calls wait out a reconnect like the outbox does, since a client that isn't in its slot drops them.
+        void RunOutboundQueue() {
+            if (ap->get_state() != ConnectionStatus::SLOT_CONNECTED) {
+                return;
+            }
+            OutboundQueue::Run();
+        }
+
+        void StartNetworkThread() {
+            network_thread_running = true;
+            network_thread = std::thread(NetworkThreadLoop);
+            Log("Started network thread");
+        }
+
+        // Must be called before ap is deleted or replaced.
+        void StopNetworkThread() {
+            if (!network_thread.joinable()) {
+                return;
+            }
+            network_thread_running = false;
+            network_thread.join();
+            // Nothing produces events anymore, so anything left over belongs to the old connection.
+            ClientEvent leftover;
+            while (event_queue.TryPop(leftover)) {}
+            Log("Stopped network thread");
+        }
 
         // The Great Wall Of Callbacks
-        {
+        // Every handler talks to ap, which is whichever client won the connection race by the time anything past room info arrives.
+        void BindHandlers(APClient* client, const string slot_name, const string password) {
             // Executes when the server sends room info; attempts to connect the player.
-            ap->set_room_info_handler([slot_name, password]() {
-                Log("Received room info");
-                int items_handling = 0b111;
-                APClient::Version version{ 0, 7, 0 };
-                ap->ConnectSlot(slot_name, password, items_handling, {}, version);
+            client->set_room_info_handler([client, slot_name, password]() {
+                NetStats::ScopedTimer timer(NetStats::Handler::RoomInfo);
+                if (client == racing_client && !SecureSideGaveUp()) {
+                    Log("Holding room info from ws:// until wss:// fails or times out");
+                    held_room_info = [client, slot_name, password]() { ReceiveRoomInfo(client, slot_name, password); };
+                    return;
+                }
+                ReceiveRoomInfo(client, slot_name, password);
                 });
 
             // Executes on successful connection to slot.
-            ap->set_slot_connected_handler([](const json& slot_data) {
+            client->set_slot_connected_handler([](const json& slot_data) {
+                NetStats::ScopedTimer timer(NetStats::Handler::SlotConnected);
                 Log("Connected to slot");
-                for (json::const_iterator iter = slot_data.begin(); iter != slot_data.end(); iter++) {
-                    GameData::SetOption(iter.key(), iter.value());
-                    if (iter.key() == "death_link" || iter.value() > 0) {
-                        ap->ConnectUpdate(false, 0, true, list<string> {"DeathLink"});
-                    }
+                Recorder::Record(Recorder::Direction::Inbound, "SlotConnected", slot_data);
+                Outbox::OpenJournal(ap->get_seed() + " " + ap->get_slot());
+                RefreshPlayers();
+                GameData::Options options = ReadSlotData(slot_data);
+
+                // Tags are sent once with the final set instead of once per option.
+                list<string> tags;
+                if (options.death_link) {
+                    tags.push_back("DeathLink");
+                }
+                if (!tags.empty()) {
+                    ap->ConnectUpdate(false, 0, true, tags);
+                    RecordSend(NetStats::Command::ConnectUpdate, tags);
                 }
-                // Delay spawning collectibles so that we have time to receive checked locations.
-                Timer::RunTimerRealTime(std::chrono::milliseconds(500), Engine::SpawnCollectibles);
                 connection_retries = 0;
+                unanswered_pings = 0;
+                last_heartbeat = std::chrono::steady_clock::now();
+                Dispatch(SlotConnectedEvent{ options });
                 });
 
             // Executes whenever a socket error is detected.
             // We want to only print an error after exactly X attempts.
-            ap->set_socket_error_handler([](const string& error) {
+            // During a connection race, the secure side failing only hands the race to the plain side,
+            // and the plain side's errors only count once it's the one the connection depends on.
+            client->set_socket_error_handler([client](const string& error) {
+                NetStats::ScopedTimer timer(NetStats::Handler::SocketError);
                 Log("Socket error: " + error);
+                if (racing_client != nullptr && client == ap) {
+                    secure_failed = true;
+                    return;
+                }
+                if (racing_client != nullptr) {
+                    // Room info from a dropped socket is no good; the reconnect will bring new room info.
+                    held_room_info = nullptr;
+                    if (!SecureSideGaveUp()) {
+                        return;
+                    }
+                }
                 if (connection_retries == max_connection_retries) {
                     if (ap->get_player_number() >= 0) { // Seed is already in progress
-                        Log(L"Lost connection with the server. Attempting to reconnect...", LogType::System);
+                        Dispatch(LogEvent{ "Lost connection with the server. Attempting to reconnect...", LogType::System });
                     }
                     else { // Attempting to connect to a new room
-                        Log(L"Could not connect to the server. Please double-check the address and ensure the server is active.", LogType::System);
+                        Dispatch(LogEvent{ "Could not connect to the server. Please double-check the address and ensure the server is active.", LogType::System });
                     }
                 }
                 connection_retries++;
                 });
 
             // Executes when the server refuses slot connection.
-            ap->set_slot_refused_handler([](const list<string>& reasons) {
+            client->set_slot_refused_handler([](const list<string>& reasons) {
+                NetStats::ScopedTimer timer(NetStats::Handler::SlotRefused);
                 string advice;
                 if (std::find(reasons.begin(), reasons.end(), "InvalidSlot") != reasons.end()
                     || std::find(reasons.begin(), reasons.end(), "InvalidPassword") != reasons.end()) {
@@ -114,209 +676,762 @@ namespace Client {
                 if (std::find(reasons.begin(), reasons.end(), "IncompatibleVersion") != reasons.end()) {
                     advice = "Please double-check your client version.";
                 }
-                Log("Could not connect to the server. " + advice, LogType::System);
+                Dispatch(LogEvent{ "Could not connect to the server. " + advice, LogType::System });
                 });
 
             // Executes whenever items are received from the server.
-            ap->set_items_received_handler([](const list<APClient::NetworkItem>& items) {
-                for (const auto& item : items) {
-                    Log(L"Receiving item with id " + std::to_wstring(item.item));
-                    GameData::ReceiveItem(item.item);
-                    Engine::SyncItems();
+            client->set_items_received_handler([](const list<APClient::NetworkItem>& items) {
+                NetStats::ScopedTimer timer(NetStats::Handler::ItemsReceived);
+                NetStats::RecordItemPacket(items.size());
+                if (Recorder::IsRecording()) {
+                    json recorded_items = json::array();
+                    for (const auto& item : items) {
+                        recorded_items.push_back({ item.item, item.location, item.player, item.flags, item.index });
+                    }
+                    Recorder::Record(Recorder::Direction::Inbound, "ItemsReceived", recorded_items);
                 }
+                Dispatch(ItemsReceivedEvent{ items });
                 });
 
             // Executes whenever a chat message is received.
-            ap->set_print_json_handler([](const APClient::PrintJSONArgs& args) {
-                using RC::Unreal::FText;
-                string plain_text = ap->render_json(args.data);
-                string markdown_text = ProcessMessageText(args);
-                Logger::PrintToConsole(
-                    StringOps::ToWide(markdown_text),
-                    StringOps::ToWide(plain_text)
-                );
-
-                if (args.type == "ItemSend") {
-                    Log(plain_text, LogType::Popup);
+            // Names are resolved here since they need ap, which leaves only the console calls for the update loop.
+            // During a release, item sends between other players are folded into a summary line per sender
+            // so they don't each cost a console call; anything sent by or to us is always printed.
+            client->set_print_json_handler([](const APClient::PrintJSONArgs& args) {
+                NetStats::ScopedTimer timer(NetStats::Handler::PrintJson);
+                bool is_item_send = args.type == "ItemSend" && args.item != nullptr && args.receiving != nullptr;
+                bool concerns_us = is_item_send && (args.item->player == ap->get_player_number() || *args.receiving == ap->get_player_number());
+                if (Recorder::IsRecording()) {
+                    json recorded_nodes = json::array();
+                    for (const auto& node : args.data) {
+                        recorded_nodes.push_back({ node.type, node.text, node.player, node.flags });
+                    }
+                    json recorded_message{ {"type", args.type}, {"data", recorded_nodes} };
+                    if (is_item_send) {
+                        recorded_message["sender"] = args.item->player;
+                        recorded_message["concerns_us"] = concerns_us;
+                    }
+                    Recorder::Record(Recorder::Direction::Inbound, "PrintJSON", recorded_message);
                 }
-                else {
-                    Log(plain_text, LogType::Console);
+                if (is_item_send && !concerns_us && MessageCoalescer::Fold(args.item->player)) {
+                    return;
                 }
+                ReceiveMessage(args.data, args.type == "ItemSend");
                 });
 
             // Executes whenever a bounce (such as a death link) is received.
-            ap->set_bounced_handler([](const json& data) {
-                Log("Receiving bounce: " + data.dump());
+            client->set_bounced_handler([](const json& data) {
+                NetStats::ScopedTimer timer(NetStats::Handler::Bounced);
+                Recorder::Record(Recorder::Direction::Inbound, "Bounced", data);
+                DecodeBounce(data);
+                });
+
+            // Executes when a new data package has been received from the server.
+            client->set_data_package_changed_handler([](const json& data_package) {
+                NetStats::ScopedTimer timer(NetStats::Handler::DataPackage);
+                Recorder::Record(Recorder::Direction::Inbound, "DataPackage", data_package);
+                NameTable::LoadDataPackage(data_package);
+                RefreshPlayers();
+                DataPackageCache::Save(data_package);
+                RenderPendingMessages(false);
+                ResolvePendingScouts(false);
+                });
 
-                auto tags = data.find("tags"); // This will either be data.end() or an array of tags.
-                if (tags == data.end()) {
-                    return; // Just ignore non-deathlink bounces.
+            // Executes when room state changes, which includes players changing their aliases.
+            client->set_room_update_handler([]() {
+                NetStats::ScopedTimer timer(NetStats::Handler::RoomUpdate);
+                RefreshPlayers();
+                });
+
+            // Executes when the server acknowledges a data storage write.
+            // The goal key is only written after the goal status update, so its reply confirms both arrived.
+            client->set_set_reply_handler([](const json& command) {
+                NetStats::ScopedTimer timer(NetStats::Handler::SetReply);
+                if (command.value("key", "") == GoalKey()) {
+                    Outbox::ConfirmGoal();
                 }
+                });
 
-                bool is_deathlink = std::find(tags->begin(), tags->end(), "DeathLink") != tags->end();
-                if (is_deathlink) {
-                    ReceiveDeathLink(data);
+            // Executes when the server answers a LocationScouts request.
+            client->set_location_info_handler([](const list<APClient::NetworkItem>& items) {
+                NetStats::ScopedTimer timer(NetStats::Handler::LocationInfo);
+                if (Recorder::IsRecording()) {
+                    json recorded_items = json::array();
+                    for (const auto& item : items) {
+                        recorded_items.push_back({ item.item, item.location, item.player, item.flags });
+                    }
+                    Recorder::Record(Recorder::Direction::Inbound, "LocationInfo", recorded_items);
                 }
+                ReceiveScouts(items);
                 });
 
             // Executes whenever the server tells us a location has been checked.
-            ap->set_location_checked_handler([](const list<int64_t>& location_ids) {
-                for (const auto& id : location_ids) {
-                    Log(L"Marking location " + std::to_wstring(id) + L" as checked");
-                    GameData::CheckLocation(id);
-                    Engine::DespawnCollectible(id);
-                }
+            client->set_location_checked_handler([](const list<int64_t>& location_ids) {
+                NetStats::ScopedTimer timer(NetStats::Handler::LocationChecked);
+                Recorder::Record(Recorder::Direction::Inbound, "LocationChecked", location_ids);
+                ReceiveLocationChecks(location_ids);
                 });
-        } // End callbacks
-    }
+        }
 
-    void Client::Disconnect() {
-        if (ap == nullptr) {
-            return;
+        // Applies the latest connect or disconnect request. Only called from the update loop.
+        void ApplyRequest() {
+            std::optional<ConnectionRequest> request;
+            std::optional<ReplayRequest> replay;
+            {
+                lock_guard<mutex> guard(request_mutex);
+                request.swap(pending_request);
+                replay.swap(pending_replay);
+            }
+            if (request && request->connect) {
+                OpenConnection(request->uri, request->slot_name, request->password);
+            }
+            else if (request) {
+                CloseConnection();
+            }
+            if (replay) {
+                StartReplay(std::move(replay->frames), replay->real_time);
+            }
         }
-        GameData::Close();
-        delete ap;
-        ap = nullptr;
-        Log("Disconnected from Archipelago.", LogType::System);
-    }
 
-    void Client::SendCheck(int64_t id) {
-        // TODO: Consider refactoring to queue location ids as an actual list
-        list<int64_t> id_list{ id };
-        Log(L"Sending check with id " + std::to_wstring(id));
-        ap->LocationChecks(id_list);
-    }
-    
-    // Sends game completion flag to Archipelago.
-    void Client::CompleteGame() {
-        if (ap == nullptr) {
-            // TODO: queue this if the player forgets to connect before winning
-            return;
+        void StartReplay(std::vector<Recorder::Frame>&& frames, bool real_time) {
+            if (connection_state != ConnectionState::Disconnected) {
+                Log(L"Please disconnect before replaying a recording.", LogType::System);
+                return;
+            }
+            if (!IsLifecycleThreadIdle()) {
+                Log(L"Please wait for the last connection to finish closing.", LogType::System);
+                return;
+            }
+            StopReplay();
+            replay_frames = std::move(frames);
+            replay_position = 0;
+            replay_real_time = real_time;
+            replay_start = std::chrono::steady_clock::now();
+            replay_skipped_frames = 0;
+            replay_held_events = 0;
+            Log("Replaying " + std::to_string(replay_frames.size()) + " frames" + (real_time ? " in real time" : ""), LogType::System);
         }
-        ap->StatusUpdate(APClient::ClientStatus::GOAL);
 
-        // Send a key to datastorage upon game completion for PopTracker integration.
-        string key =
-            "Pseudoregalia - Team " + std::to_string(ap->get_team_number())
-            + " - Player " + std::to_string(ap->get_player_number())
-            + " - Game Complete";
-        json default_value{ 0 };
-        list<APClient::DataStorageOperation> filler_operations{ APClient::DataStorageOperation{ "add", default_value  } };
-        ap->Set(key, default_value, true, filler_operations);
-    }
+        // Only hands the work to the lifecycle thread; the client starts polling once PollServer adopts it.
+        void OpenConnection(const string uri, const string slot_name, const string password) {
+            StopReplay();
+            // The network thread may still be recording, so it has to be stopped before the recording is closed.
+            DetachClients();
+            Recorder::Stop();
+            if (record_sessions) {
+                Recorder::Start();
+            }
+            Outbox::OnConnect();
+            // Anything queued for the old connection was meant for its slot, which may not be the one we're connecting to.
+            OutboundQueue::Clear();
+            connection_state = ConnectionState::Building;
+            uint64_t generation;
+            {
+                lock_guard<mutex> guard(lifecycle_mutex);
+                generation = ++connect_generation;
+                built_client.reset();
+            }
+            RunOnLifecycleThread([uri, slot_name, password, generation]() {
+                BuildClients(uri, slot_name, password, generation);
+                });
+            string connect_message(
+                "Attempting to connect to " + uri
+                + " with name " + slot_name + "...");
+            Log(connect_message, LogType::System);
+        }
 
-    void Client::PollServer() {
-        if (ap == nullptr) {
-            return;
+        void CloseConnection() {
+            if (connection_state == ConnectionState::Disconnected) {
+                return;
+            }
+            DetachClients();
+            Recorder::Stop();
+            NetStats::Reset();
+            GameData::Close();
+            Outbox::Reset();
+            OutboundQueue::Clear();
+            ScoutCache::Clear();
+            ClockSync::Reset();
+            MessageCoalescer::Reset();
+            {
+                // Any client still being built is now stale and gets thrown away when it's done.
+                lock_guard<mutex> guard(lifecycle_mutex);
+                connect_generation++;
+                built_client.reset();
+            }
+            // DetachClients stopped the network thread, so the name table belongs to this thread again.
+            // Builds on the lifecycle thread only read cached checksums and never touch it.
+            NameTable::Clear();
+            connection_state = ConnectionState::Disconnected;
+            Log("Disconnected from Archipelago.", LogType::System);
         }
-        ap->poll();
-    }
 
-    void Client::SendDeathLink() {
-        using DeathLinkMessages::RandomOutgoingDeathlink;
-        using DeathLinkMessages::RandomOwnDeathlink;
-        if (ap == nullptr
-        || !GameData::GetOptions().at("death_link")
-        || death_link_locked) {
-            return;
+        // Takes ap away from the update loop and hands it to the lifecycle thread to be torn down.
+        // Stopping the network thread drains event_queue, so this must only run on the update loop, its one consumer.
+        void DetachClients() {
+            StopNetworkThread();
+            APClient* client = ap;
+            APClient* racer = racing_client;
+            ap = nullptr;
+            racing_client = nullptr;
+            held_room_info = nullptr;
+            if (client == nullptr) {
+                return;
+            }
+            RunOnLifecycleThread([client, racer]() {
+                DestroyClients(client, racer);
+                });
         }
 
-        string funny_message(std::vformat(RandomOutgoingDeathlink(), std::make_format_args(ap->get_slot())));
-        json data{
-            {"time", ap->get_server_time()},
-            {"cause", funny_message},
-            {"source", ap->get_slot()},
-        };
-        ap->Bounce(data, {}, {}, { "DeathLink" });
-        Log(RandomOwnDeathlink(), LogType::Popup);
-        Log("Sending bounce: " + data.dump());
-        Timer::RunTimerInGame(death_link_timer_seconds, &death_link_locked);
-    }
+        // Picks up clients the lifecycle thread finished building. Does nothing if they aren't ready yet.
+        void AdoptClients() {
+            {
+                lock_guard<mutex> guard(lifecycle_mutex);
+                if (!built_client) {
+                    return;
+                }
+                ap = built_client->client;
+                racing_client = built_client->racer;
+                built_client.reset();
+            }
+            connection_state = ConnectionState::Active;
+            connection_retries = 0;
+            race_start = std::chrono::steady_clock::now();
+            secure_failed = false;
+            held_room_info = nullptr;
+            if (use_network_thread) {
+                StartNetworkThread();
+            }
+        }
 
-    void Client::Say(string input) {
-        if (ap == nullptr) {
-            return;
+        // Jobs run one at a time in the order they were queued, so a teardown always finishes before the next build starts.
+        void RunOnLifecycleThread(std::function<void()> job) {
+            lock_guard<mutex> guard(lifecycle_mutex);
+            if (lifecycle_stopping) {
+                return;
+            }
+            if (!lifecycle_thread.joinable()) {
+                // Lives as long as the mod does, and is joined by Shutdown when the mod is unloaded.
+                lifecycle_thread = std::thread(LifecycleThreadLoop);
+            }
+            lifecycle_jobs.push_back(std::move(job));
+            lifecycle_condition.notify_one();
         }
 
-        ap->Say(input);
-    }
+        bool IsLifecycleThreadIdle() {
+            lock_guard<mutex> guard(lifecycle_mutex);
+            return lifecycle_jobs.empty() && !lifecycle_busy;
+        }
 
+        // Jobs already queued still run, so a client handed over by DetachClients is torn down before the thread exits.
+        void StopLifecycleThread() {
+            {
+                lock_guard<mutex> guard(lifecycle_mutex);
+                lifecycle_stopping = true;
+                lifecycle_condition.notify_one();
+            }
+            if (lifecycle_thread.joinable()) {
+                lifecycle_thread.join();
+            }
+        }
 
-    // Private functions
-    namespace {
-        string ProcessMessageText(const APClient::PrintJSONArgs& args) {
-            string console_text;
+        void LifecycleThreadLoop() {
+            while (true) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<mutex> lock(lifecycle_mutex);
+                    lifecycle_condition.wait(lock, []() { return !lifecycle_jobs.empty() || lifecycle_stopping; });
+                    if (lifecycle_jobs.empty()) {
+                        return;
+                    }
+                    job = std::move(lifecycle_jobs.front());
+                    lifecycle_jobs.pop_front();
+                    lifecycle_busy = true;
+                }
+                job();
+                lock_guard<mutex> guard(lifecycle_mutex);
+                lifecycle_busy = false;
+            }
+        }
+
+        void BuildClients(const string uri, const string slot_name, const string password, uint64_t generation) {
+            // With the cached checksums set, the client only requests packages for games in the room that aren't cached.
+            // Cached names are read lazily by NameTable, so games nobody in the room is playing are never loaded.
+            json cached_data_package = DataPackageCache::LoadChecksums();
+            APClient* client;
+            APClient* racer = nullptr;
+            if (uri.find("://") == string::npos) {
+                // Without a scheme, try a secure and a plain connection side by side instead of one after the other.
+                client = BuildClient("wss://" + uri, cached_data_package);
+                racer = BuildClient("ws://" + uri, cached_data_package);
+            }
+            else {
+                client = BuildClient(uri, cached_data_package);
+            }
+            BindHandlers(client, slot_name, password);
+            if (racer != nullptr) {
+                BindHandlers(racer, slot_name, password);
+            }
+
+            {
+                lock_guard<mutex> guard(lifecycle_mutex);
+                if (generation == connect_generation) {
+                    built_client = BuiltClients{ client, racer };
+                    return;
+                }
+            }
+            Log("Discarding a client that was replaced before it finished building");
+            DestroyClients(client, racer);
+        }
+
+        // Deleting a client closes its socket, which can block, so this only runs on the lifecycle thread.
+        void DestroyClients(APClient* client, APClient* racer) {
+            delete racer;
+            delete client;
+        }
+
+        APClient* BuildClient(const string& uri, const json& data_package) {
+            APClient* client = new APClient(uuid, game_name, uri, cert_store);
+            if (!data_package.is_null()) {
+                client->set_data_package(data_package);
+            }
+            return client;
+        }
+
+        // Polls ap, plus the other side of a connection race once its stagger has passed or the secure side has failed.
+        void PollClients() {
+            NetStats::ScopedTimer timer(NetStats::Handler::Poll);
+            ap->poll();
+            if (racing_client != nullptr && (secure_failed || std::chrono::steady_clock::now() - race_start >= race_stagger)) {
+                racing_client->poll();
+            }
+            if (held_room_info && SecureSideGaveUp()) {
+                std::function<void()> receive_room_info = std::move(held_room_info);
+                held_room_info = nullptr;
+                receive_room_info();
+            }
+            RenderPendingMessages(false);
+            ResolvePendingScouts(false);
+            PrintSummaries(false);
+            FetchUnreadableGames();
+        }
+
+        // Game data has to be ready before the server starts sending checked locations for this slot.
+        void ReceiveRoomInfo(APClient* client, const string& slot_name, const string& password) {
+            ClaimRace(client);
+            Log("Received room info");
+            string session(ap->get_seed() + " " + slot_name);
+            Recorder::Record(Recorder::Direction::Inbound, "RoomInfo", session);
+            ClockSync::OnRoomInfo(ap->get_server_time());
+            pending_messages.clear();
+            pending_scouts.clear();
+            Dispatch(RoomInfoEvent{ session });
+            int items_handling = 0b111;
+            APClient::Version version{ 0, 7, 0 };
+            ap->ConnectSlot(slot_name, password, items_handling, {}, version);
+            RecordSend(NetStats::Command::ConnectSlot, slot_name);
+        }
+
+        // A socket error is the usual way out, but a secure side that never gets anywhere gives up after race_timeout.
+        bool SecureSideGaveUp() {
+            return secure_failed || std::chrono::steady_clock::now() - race_start >= race_timeout;
+        }
+
+        // The secure client keeps the connection as soon as it gets room info, and the plain one only once the secure one gave up.
+        // The other one is dropped. This runs from inside the winner's poll or after both polls, so the loser is never mid-poll
+        // when it's handed to the lifecycle thread to be deleted.
+        void ClaimRace(APClient* winner) {
+            if (racing_client == nullptr) {
+                return;
+            }
+            bool secure = winner == ap;
+            APClient* loser = secure ? racing_client : ap;
+            ap = winner;
+            racing_client = nullptr;
+            held_room_info = nullptr;
+            RunOnLifecycleThread([loser]() {
+                DestroyClients(loser, nullptr);
+                });
+            // Failures from the losing side shouldn't count against the winner.
+            connection_retries = 0;
+            Log(secure ? "Connected with wss://" : "Connected with ws://");
+        }
+
+        void NetworkThreadLoop() {
+            while (network_thread_running) {
+                PollClients();
+                FlushOutbox();
+                Heartbeat();
+                RunOutboundQueue();
+                std::this_thread::sleep_for(network_poll_interval);
+            }
+        }
+
+        // Applies a whole ReceivedItems packet at once and only marks items for syncing a single time.
+        // Items that were already applied earlier in the session are skipped using their index.
+        void ReceiveItems(const list<APClient::NetworkItem>& items) {
+            if (items.empty()) {
+                return;
+            }
+            int first_index = items.front().index;
+            int next_index = GameData::GetNextItemIndex();
+            if (first_index > next_index) {
+                // We missed some items, so ask the server for everything again.
+                Log("Expected item index " + std::to_string(next_index) + " but received " + std::to_string(first_index)
+                    + "; requesting a resync", LogType::Warning);
+                Post(OutboundQueue::Priority::Game, []() {
+                    ap->Sync();
+                    RecordSend(NetStats::Command::Sync);
+                    });
+                return;
+            }
+            if (first_index == 0 && static_cast<int>(items.size()) < next_index) {
+                // The server knows about fewer items than we've applied, so our state can't be trusted anymore.
+                Log("Server sent " + std::to_string(items.size()) + " items but " + std::to_string(next_index)
+                    + " were already applied; rebuilding items from scratch", LogType::Warning);
+                GameData::ResetItems();
+                next_index = 0;
+            }
+
+            int counts[5] = {};
+            int applied = 0;
+            for (const auto& item : items) {
+                if (item.index < next_index) {
+                    continue;
+                }
+                GameData::ItemType type = GameData::ReceiveItem(item.item);
+                counts[static_cast<int>(type)]++;
+                applied++;
+            }
+            GameData::SetNextItemIndex(std::max(next_index, items.back().index + 1));
+            if (applied == 0) {
+                Log("Skipped " + std::to_string(items.size()) + " items that were already applied");
+                return;
+            }
+            Engine::SyncItems();
+
+            Log("Received " + std::to_string(applied) + " new items out of " + std::to_string(items.size())
+                + " starting at index " + std::to_string(first_index)
+                + " (" + std::to_string(counts[static_cast<int>(GameData::ItemType::Ability)]) + " abilities, "
+                + std::to_string(counts[static_cast<int>(GameData::ItemType::HealthPiece)]) + " health pieces, "
+                + std::to_string(counts[static_cast<int>(GameData::ItemType::SmallKey)]) + " small keys, "
+                + std::to_string(counts[static_cast<int>(GameData::ItemType::MajorKey)]) + " major keys, "
+                + std::to_string(counts[static_cast<int>(GameData::ItemType::Unknown)]) + " unknown)");
+        }
+
+        void ReceiveMessage(const list<APClient::TextNode>& nodes, bool is_item_send) {
+            if (pending_messages.empty() && HasNamesFor(nodes)) {
+                DispatchMessage(nodes, is_item_send);
+                return;
+            }
+            pending_messages.push_back(PendingMessage{ nodes, is_item_send, std::chrono::steady_clock::now() });
+            RenderPendingMessages(false);
+        }
+
+        void DispatchMessage(const list<APClient::TextNode>& nodes, bool is_item_send) {
+            // Rendering happens into buffers that keep their capacity between messages,
+            // so the only allocations left are the exact-size copies handed to the event.
+            static std::wstring markdown_buffer;
+            static std::wstring plain_buffer;
+            RenderMessage(nodes, markdown_buffer, plain_buffer);
+            Dispatch(PrintEvent{
+                markdown_buffer,
+                plain_buffer,
+                is_item_send,
+                });
+        }
+
+        // Only item and location names depend on a game's package; player names come with the room.
+        bool HasNamesFor(const list<APClient::TextNode>& nodes) {
+            for (const auto& node : nodes) {
+                if ((node.type == "item_id" || node.type == "location_id") && !NameTable::HasNames(node.player)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Renders held messages once their names have arrived. Anything held too long renders anyway, unknown names and all.
+        void RenderPendingMessages(bool render_all) {
+            auto now = std::chrono::steady_clock::now();
+            while (!pending_messages.empty()) {
+                const PendingMessage& message = pending_messages.front();
+                bool overdue = now - message.received >= pending_message_timeout || pending_messages.size() > max_pending_messages;
+                if (!render_all && !overdue && !HasNamesFor(message.nodes)) {
+                    return;
+                }
+                DispatchMessage(message.nodes, message.is_item_send);
+                pending_messages.pop_front();
+            }
+        }
+
+        // Prints a line for each run of item sends that was folded away, once its window has closed.
+        void PrintSummaries(bool close_all) {
+            for (const MessageCoalescer::Summary& summary : MessageCoalescer::TakeClosedRuns(close_all)) {
+                std::wstring plain_text;
+                StringOps::AppendWide(plain_text, NameTable::GetPlayerAlias(summary.sender));
+                std::wstring markdown_text = L"<Player>" + plain_text + L"</>";
+                std::wstring rest = L" sent " + std::to_wstring(summary.folded) + (summary.folded == 1 ? L" more item" : L" more items") + L" to other players";
+                plain_text += rest;
+                markdown_text += rest;
+                Dispatch(PrintEvent{ markdown_text, plain_text, false });
+            }
+        }
+
+        // Renders a message into RichTextBlock markdown and plain text in a single walk over its nodes.
+        // Each name is transcoded to UTF-16 once into the plain text and then copied into the markdown.
+        void RenderMessage(const list<APClient::TextNode>& nodes, std::wstring& markdown_text, std::wstring& plain_text) {
+            using StringOps::AppendWide;
+            markdown_text.clear();
+            plain_text.clear();
+            // Names are usually about as long as the ids they replace; the extra room covers markup tags.
+            size_t expected_length = 0;
+            for (const auto& node : nodes) {
+                expected_length += node.text.size() + 24;
+            }
+            markdown_text.reserve(expected_length);
+            plain_text.reserve(expected_length);
+
+            auto append_name = [&markdown_text, &plain_text](std::string_view name) {
+                size_t start = plain_text.size();
+                AppendWide(plain_text, name);
+                markdown_text.append(plain_text, start);
+                };
 
             // This loop is basically the logic of APClient::render_json(), adapted to use RichTextBlock markdown.
             // Later on this will be stylized to consider the perspective of the player.
-            for (const auto& node : args.data) {
+            for (const auto& node : nodes) {
                 size_t type_hash = StringOps::HashNstring(node.type);
                 switch (type_hash) {
                 case Hashes::player_id: {
-                    int id = std::stoi(node.text);
-                    string player_name = ap->get_player_alias(id);
-                    console_text += "<Player>" + player_name + "</>";
+                    int id = ParseId<int>(node.text);
+                    markdown_text += L"<Player>";
+                    append_name(NameTable::GetPlayerAlias(id));
+                    markdown_text += L"</>";
                     break;
                 }
                 case Hashes::item_id: {
-                    int64_t id = std::stoll(node.text);
-                    string item_name = ap->get_item_name(id);
+                    int64_t id = ParseId<int64_t>(node.text);
                     switch (node.flags) {
                     case APClient::FLAG_ADVANCEMENT:
-                        console_text += "<Progression";
+                        markdown_text += L"<Progression";
                         break;
                     case APClient::FLAG_NEVER_EXCLUDE:
-                        console_text += "<Useful";
+                        markdown_text += L"<Useful";
                         break;
                     case APClient::FLAG_TRAP:
-                        console_text += "<Trap";
+                        markdown_text += L"<Trap";
                         break;
                     default:
-                        console_text += "<Filler";
+                        markdown_text += L"<Filler";
                         break;
                     }
-                    console_text += "Item>" + item_name + "</>";
+                    markdown_text += L"Item>";
+                    append_name(NameTable::GetItemName(id, node.player));
+                    markdown_text += L"</>";
                     break;
                 }
                 case Hashes::location_id: {
-                    int64_t id = std::stoll(node.text);
-                    string location_name = ap->get_location_name(id);
-                    console_text += "<Location>" + location_name + "</>";
+                    int64_t id = ParseId<int64_t>(node.text);
+                    markdown_text += L"<Location>";
+                    append_name(NameTable::GetLocationName(id, node.player));
+                    markdown_text += L"</>";
                     break;
                 }
                 default:
-                    console_text += node.text;
+                    append_name(node.text);
                     break;
                 }
             }
+        }
+
+        // Gives the name table the current alias and game of every player in the room.
+        void RefreshPlayers() {
+            std::vector<NameTable::Player> players;
+            for (const auto& player : ap->get_players()) {
+                players.push_back(NameTable::Player{ player.slot, player.alias, ap->get_player_game(player.slot) });
+            }
+            if (Recorder::IsRecording()) {
+                json recorded_players = json::array();
+                for (const auto& player : players) {
+                    recorded_players.push_back({ player.slot, player.alias, player.game });
+                }
+                Recorder::Record(Recorder::Direction::Inbound, "Players", recorded_players);
+            }
+            NameTable::SetPlayers(players);
+        }
+
+        // Cached games we offered stand-ins for are never fetched by apclientpp, so any whose file couldn't be read are asked for here.
+        void FetchUnreadableGames() {
+            std::vector<string> games = NameTable::TakeGamesToFetch();
+            if (games.empty()) {
+                return;
+            }
+            list<string> include(games.begin(), games.end());
+            Post(OutboundQueue::Priority::Game, [include]() {
+                ap->GetDataPackage(include);
+                RecordSend(NetStats::Command::GetDataPackage, include);
+                });
+        }
+
+        GameData::Options ReadSlotData(const json& slot_data) {
+            GameData::Options options;
+            if (!SlotData::Parse(slot_data, options)) {
+                Dispatch(LogEvent{ "This seed's slot data wasn't recognized. Make sure your client version matches the apworld it was generated with.", LogType::Error });
+            }
+            return options;
+        }
+
+        void ReceiveLocationChecks(const list<int64_t>& location_ids) {
+            for (const auto& id : location_ids) {
+                Outbox::MarkChecked(id);
+            }
+            Dispatch(LocationsCheckedEvent{ location_ids });
+        }
+
+        void ReceiveScouts(const list<APClient::NetworkItem>& items) {
+            if (pending_scouts.empty()) {
+                pending_scouts_received = std::chrono::steady_clock::now();
+            }
+            pending_scouts.insert(pending_scouts.end(), items.begin(), items.end());
+            ResolvePendingScouts(false);
+        }
+
+        // Names every scouted item whose receiver's game has its names loaded, and hands them to the cache.
+        // Anything held too long is resolved anyway, unknown names and all.
+        // For scouts, the player is whoever receives the item rather than whoever finds it.
+        void ResolvePendingScouts(bool resolve_all) {
+            if (pending_scouts.empty()) {
+                return;
+            }
+            bool overdue = resolve_all || std::chrono::steady_clock::now() - pending_scouts_received >= pending_message_timeout;
+            std::vector<ScoutCache::ScoutedItem> scouted;
+            for (auto item = pending_scouts.begin(); item != pending_scouts.end(); ) {
+                if (!overdue && !NameTable::HasNames(item->player)) {
+                    item++;
+                    continue;
+                }
+                scouted.push_back(ScoutCache::ScoutedItem{
+                    item->location, item->item, item->player, item->flags,
+                    string(NameTable::GetItemName(item->item, item->player)),
+                    string(NameTable::GetPlayerAlias(item->player)),
+                    });
+                item = pending_scouts.erase(item);
+            }
+            if (!scouted.empty()) {
+                Dispatch(ScoutsEvent{ std::move(scouted) });
+            }
+        }
+
+        // Parses an id out of node text without allocating or throwing. Malformed text parses as 0.
+        template <typename T>
+        T ParseId(const string& text) {
+            T id = 0;
+            std::from_chars(text.data(), text.data() + text.size(), id);
+            return id;
+        }
+
+        void SendGoal() {
+            ap->StatusUpdate(APClient::ClientStatus::GOAL);
+            RecordSend(NetStats::Command::StatusUpdate);
+
+            // Send a key to datastorage upon game completion for PopTracker integration.
+            // It's queued behind the status update, which went out first, so its reply still confirms both arrived.
+            Post(OutboundQueue::Priority::Storage, []() {
+                json default_value{ 0 };
+                list<APClient::DataStorageOperation> filler_operations{ APClient::DataStorageOperation{ "add", default_value  } };
+                ap->Set(GoalKey(), default_value, true, filler_operations);
+                RecordSend(NetStats::Command::Set);
+                });
+        }
 
-            return console_text;
+        string GoalKey() {
+            return "Pseudoregalia - Team " + std::to_string(ap->get_team_number())
+                + " - Player " + std::to_string(ap->get_player_number())
+                + " - Game Complete";
         }
 
-        void ReceiveDeathLink(const json& data) {
-            if (ap == nullptr
-                || !GameData::GetOptions().at("death_link")
+        // Picks the fields we need out of a bounce without copying it, and drops anything that isn't a death link.
+        // Rooms with lots of DeathLink games send far more bounces than we care about, so this needs to stay cheap.
+        void DecodeBounce(const json& data) {
+            auto tags = data.find("tags"); // This will either be data.end() or an array of tags.
+            bool has_tags = tags != data.end() && tags->is_array();
+            // Pings arrive every few seconds, so they're handled before the verbose dump to keep it readable.
+            if (has_tags && std::find(tags->begin(), tags->end(), ping_tag) != tags->end()) {
+                ReceivePing(data);
+                return;
+            }
+
+            if (Logger::IsVerbose()) {
+                Log("Receiving bounce: " + data.dump());
+            }
+            if (!has_tags) {
+                return; // Just ignore non-deathlink bounces.
+            }
+            bool is_deathlink = std::find(tags->begin(), tags->end(), "DeathLink") != tags->end();
+            if (!is_deathlink) {
+                return;
+            }
+
+            DeathLinkEvent event{};
+            auto details = data.find("data");
+            if (details != data.end() && details->is_object()) {
+                event.has_details = true;
+                auto time = details->find("time");
+                if (time != details->end() && time->is_number()) {
+                    event.time = time->get<double>();
+                }
+                auto source = details->find("source");
+                if (source != details->end() && source->is_string()) {
+                    event.source = source->get<string>();
+                }
+                auto cause = details->find("cause");
+                if (cause != details->end() && cause->is_string()) {
+                    event.cause = cause->get<string>();
+                }
+            }
+
+            // Deaths that sat in a buffer through a reconnect shouldn't all land at once, long after they happened.
+            // Replayed deaths are always old, but they're ignored by ReceiveDeathLink anyway.
+            if (ap != nullptr && event.time > 0) {
+                double age_seconds = ClockSync::ServerNow() - event.time;
+                int max_age_seconds = death_link_max_age_seconds;
+                if (max_age_seconds > 0 && age_seconds > max_age_seconds) {
+                    NetStats::RecordStaleDeathLink();
+                    Log(std::format("Ignoring a DeathLink from {} that is {:.1f}s old. If their clock is off, "
+                        "\"/deathlinkage <seconds>\" raises the limit from {}s, and 0 turns it off.", event.source, age_seconds, max_age_seconds),
+                        LogType::Warning);
+                    return;
+                }
+                NetStats::RecordDeathLink(std::chrono::microseconds(static_cast<int64_t>(age_seconds * 1000000.0)));
+                if (Logger::IsVerbose()) {
+                    Log(std::format("DeathLink from {} took {:.0f}ms to arrive", event.source, age_seconds * 1000.0));
+                }
+            }
+            Dispatch(std::move(event));
+        }
+
+        void ReceiveDeathLink(const DeathLinkEvent& death_link) {
+            // Replayed deaths land here too, but there's no connection during a replay.
+            if (connection_state != ConnectionState::Active
+                || !GameData::GetOptions().death_link
                 || death_link_locked) {
                 return;
             }
 
-            if (!data.contains("data")) {
+            if (!death_link.has_details) {
                 // Should only execute if the received death link data was not properly filled out.
                 Log("You were assassinated by a mysterious villain...", LogType::Popup);
                 Engine::VaporizeGoat();
                 Timer::RunTimerInGame(death_link_timer_seconds, &death_link_locked);
                 return;
             }
-            json details = data["data"];
-            string funny_message;
 
-            if (details.contains("cause")) {
-                string cause(details["cause"]);
-                Log(cause, LogType::Popup);
+            if (!death_link.cause.empty()) {
+                Log(death_link.cause, LogType::Popup);
             }
-            else if (details.contains("source")) {
-                string source(details["source"]);
-                Log("You were brutally murdered by " + source + ".", LogType::Popup);
+            else if (!death_link.source.empty()) {
+                Log("You were brutally murdered by " + death_link.source + ".", LogType::Popup);
             }
             else {
                 // Should only execute if the received death link data was not properly filled out.
@@ -325,5 +1440,244 @@ namespace Client {
             Engine::VaporizeGoat();
             Timer::RunTimerInGame(death_link_timer_seconds, &death_link_locked);
         }
+
+        // Only pings sent by this client count, since another client on the same slot has its own clock.
+        void ReceivePing(const json& data) {
+            // Pings from a replayed recording say nothing about the current connection.
+            if (ap == nullptr) {
+                return;
+            }
+            auto details = data.find("data");
+            if (details == data.end() || !details->is_object() || details->value("client", "") != uuid) {
+                return;
+            }
+            auto sent = details->find("sent");
+            if (sent == details->end() || !sent->is_number_integer()) {
+                return;
+            }
+            auto now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch());
+            std::chrono::microseconds round_trip = now - std::chrono::microseconds(sent->get<int64_t>());
+            if (round_trip.count() < 0) {
+                return;
+            }
+            NetStats::RecordRoundTrip(round_trip);
+            ClockSync::OnRoundTrip(round_trip);
+            unanswered_pings = 0;
+            last_heartbeat = std::chrono::steady_clock::now();
+        }
+
+        // Bounces our own steady clock off the server to measure round trip time.
+        // The send time is stamped when the ping actually leaves the queue, so time spent waiting there isn't counted.
+        void SendPing() {
+            last_ping = std::chrono::steady_clock::now();
+            unanswered_pings++;
+            Post(OutboundQueue::Priority::Game, []() {
+                auto sent = std::chrono::steady_clock::now().time_since_epoch();
+                json data{
+                    {"client", uuid},
+                    {"sent", std::chrono::duration_cast<std::chrono::microseconds>(sent).count()},
+                };
+                ap->Bounce(data, {}, { ap->get_player_number() }, { ping_tag });
+                RecordSend(NetStats::Command::Ping);
+                });
+        }
+
+        // Drops the socket so that apclientpp reconnects on the next poll.
+        void ResetDeadConnection() {
+            auto silence = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - last_heartbeat);
+            Log("No heartbeat reply in " + std::to_string(silence.count()) + "ms after " + std::to_string(unanswered_pings)
+                + " pings; resetting the connection", LogType::Warning);
+            Dispatch(LogEvent{ "Lost connection with the server. Attempting to reconnect...", LogType::System });
+            unanswered_pings = 0;
+            // Checks sent during the outage may never have arrived, so they go out again once the slot reconnects.
+            Outbox::OnConnect();
+            ap->reset();
+        }
+
+        // Counts a sent command, and records it too if this session is being recorded.
+        void RecordSend(NetStats::Command command, const json& payload) {
+            NetStats::RecordCommand(command);
+            Recorder::Record(Recorder::Direction::Outbound, NetStats::GetCommandName(command), payload);
+        }
+
+        void StopReplay() {
+            if (replay_frames.empty()) {
+                return;
+            }
+            replay_frames.clear();
+            // Anything the handlers tried to send during the replay was meant for a server that doesn't exist.
+            OutboundQueue::Clear();
+            // The replayed room's names and pending output shouldn't leak into the next connection.
+            NameTable::Clear();
+            MessageCoalescer::Reset();
+            pending_messages.clear();
+            pending_scouts.clear();
+        }
+
+        // Without real timing, the whole recording is applied at once so the log shows the pipeline's throughput.
+        void StepReplay() {
+            auto now = std::chrono::steady_clock::now();
+            int64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - replay_start).count();
+            while (replay_position < replay_frames.size()) {
+                const Recorder::Frame& frame = replay_frames[replay_position];
+                if (replay_real_time && frame.time_us > elapsed) {
+                    RenderPendingMessages(false);
+                    ResolvePendingScouts(false);
+                    PrintSummaries(false);
+                    return;
+                }
+                if (frame.direction == Recorder::Direction::Inbound && IsWellFormed(frame)) {
+                    ReplayFrame(frame);
+                }
+                else if (frame.direction == Recorder::Direction::Inbound) {
+                    Log("Skipping malformed " + frame.kind + " frame " + std::to_string(replay_position), LogType::Warning);
+                    replay_skipped_frames++;
+                }
+                replay_position++;
+            }
+            RenderPendingMessages(true);
+            ResolvePendingScouts(true);
+            PrintSummaries(true);
+
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - replay_start);
+            double seconds = std::max(duration.count(), int64_t{ 1 }) / 1000000.0;
+            Log(std::format("Replayed {} frames in {:.3f}s ({:.0f} frames per second), skipped {} malformed frames and held back {} game state events",
+                replay_frames.size(), seconds, replay_frames.size() / seconds, replay_skipped_frames, replay_held_events), LogType::System);
+            StopReplay();
+        }
+
+        // Checks that a frame has the shape ReplayFrame reads, so a hand-edited or truncated recording can't throw mid-update.
+        // Unknown kinds are fine since ReplayFrame ignores them.
+        bool IsWellFormed(const Recorder::Frame& frame) {
+            const json& payload = frame.payload;
+            auto is_integer_array = [](const json& value, size_t min_size) {
+                if (!value.is_array() || value.size() < min_size) {
+                    return false;
+                }
+                return std::all_of(value.begin(), value.begin() + min_size, [](const json& field) { return field.is_number_integer(); });
+            };
+            auto is_name_table = [](const json& package, const char* key) {
+                auto names = package.find(key);
+                return names == package.end()
+                    || (names->is_object() && std::all_of(names->begin(), names->end(), [](const json& id) { return id.is_number_integer(); }));
+            };
+            if (frame.kind == "RoomInfo") {
+                return payload.is_string();
+            }
+            if (frame.kind == "Players") {
+                return payload.is_array() && std::all_of(payload.begin(), payload.end(), [](const json& player) {
+                    return player.is_array() && player.size() >= 3 && player[0].is_number_integer() && player[1].is_string() && player[2].is_string();
+                    });
+            }
+            if (frame.kind == "DataPackage") {
+                if (!payload.is_object() || !payload.contains("games") || !payload["games"].is_object()) {
+                    return false;
+                }
+                return std::all_of(payload["games"].begin(), payload["games"].end(), [&](const json& package) {
+                    return package.is_object() && is_name_table(package, "item_name_to_id") && is_name_table(package, "location_name_to_id");
+                    });
+            }
+            if (frame.kind == "ItemsReceived" || frame.kind == "LocationInfo") {
+                size_t fields = frame.kind == "ItemsReceived" ? 5 : 4;
+                return payload.is_array() && std::all_of(payload.begin(), payload.end(), [&](const json& item) { return is_integer_array(item, fields); });
+            }
+            if (frame.kind == "LocationChecked") {
+                return payload.is_array() && std::all_of(payload.begin(), payload.end(), [](const json& id) { return id.is_number_integer(); });
+            }
+            if (frame.kind == "PrintJSON") {
+                if (!payload.is_object() || !payload.contains("data") || !payload["data"].is_array()) {
+                    return false;
+                }
+                if ((payload.contains("type") && !payload["type"].is_string())
+                    || (payload.contains("sender") && !payload["sender"].is_number_integer())
+                    || (payload.contains("concerns_us") && !payload["concerns_us"].is_boolean())) {
+                    return false;
+                }
+                return std::all_of(payload["data"].begin(), payload["data"].end(), [](const json& node) {
+                    return node.is_array() && node.size() >= 4 && node[0].is_string() && node[1].is_string()
+                        && node[2].is_number_integer() && node[3].is_number_integer();
+                    });
+            }
+            if (frame.kind == "SlotConnected" || frame.kind == "Bounced") {
+                return payload.is_object();
+            }
+            return true;
+        }
+
+        // Mirrors the handlers in Connect, minus everything that would need to talk to the server.
+        void ReplayFrame(const Recorder::Frame& frame) {
+            const json& payload = frame.payload;
+            if (frame.kind == "RoomInfo") {
+                Dispatch(RoomInfoEvent{ payload.get<string>() });
+            }
+            else if (frame.kind == "SlotConnected") {
+                Dispatch(SlotConnectedEvent{ ReadSlotData(payload) });
+            }
+            else if (frame.kind == "Players") {
+                std::vector<NameTable::Player> players;
+                for (const auto& player : payload) {
+                    players.push_back(NameTable::Player{ player[0].get<int>(), player[1].get<string>(), player[2].get<string>() });
+                }
+                NameTable::SetPlayers(players);
+            }
+            else if (frame.kind == "DataPackage") {
+                NameTable::LoadDataPackage(payload);
+                RenderPendingMessages(false);
+                ResolvePendingScouts(false);
+            }
+            else if (frame.kind == "ItemsReceived") {
+                NetStats::ScopedTimer timer(NetStats::Handler::ItemsReceived);
+                list<APClient::NetworkItem> items;
+                for (const auto& recorded_item : payload) {
+                    APClient::NetworkItem item;
+                    item.item = recorded_item[0].get<int64_t>();
+                    item.location = recorded_item[1].get<int64_t>();
+                    item.player = recorded_item[2].get<int>();
+                    item.flags = recorded_item[3].get<unsigned>();
+                    item.index = recorded_item[4].get<int>();
+                    items.push_back(item);
+                }
+                NetStats::RecordItemPacket(items.size());
+                Dispatch(ItemsReceivedEvent{ items });
+            }
+            else if (frame.kind == "LocationChecked") {
+                NetStats::ScopedTimer timer(NetStats::Handler::LocationChecked);
+                // Skips ReceiveLocationChecks, since marking them in the Outbox would drop real checks still waiting to be sent.
+                Dispatch(LocationsCheckedEvent{ payload.get<list<int64_t>>() });
+            }
+            else if (frame.kind == "PrintJSON") {
+                NetStats::ScopedTimer timer(NetStats::Handler::PrintJson);
+                list<APClient::TextNode> nodes;
+                for (const auto& recorded_node : payload["data"]) {
+                    APClient::TextNode node;
+                    node.type = recorded_node[0].get<string>();
+                    node.text = recorded_node[1].get<string>();
+                    node.player = recorded_node[2].get<int>();
+                    node.flags = recorded_node[3].get<unsigned>();
+                    nodes.push_back(node);
+                }
+                if (payload.contains("sender") && !payload.value("concerns_us", true) && MessageCoalescer::Fold(payload["sender"].get<int>())) {
+                    return;
+                }
+                ReceiveMessage(nodes, payload.value("type", "") == "ItemSend");
+            }
+            else if (frame.kind == "Bounced") {
+                NetStats::ScopedTimer timer(NetStats::Handler::Bounced);
+                DecodeBounce(payload);
+            }
+            else if (frame.kind == "LocationInfo") {
+                NetStats::ScopedTimer timer(NetStats::Handler::LocationInfo);
+                list<APClient::NetworkItem> items;
+                for (const auto& recorded_item : payload) {
+                    APClient::NetworkItem item;
+                    item.item = recorded_item[0].get<int64_t>();
+                    item.location = recorded_item[1].get<int64_t>();
+                    item.player = recorded_item[2].get<int>();
+                    item.flags = recorded_item[3].get<unsigned>();
+                    items.push_back(item);
+                }
+                ReceiveScouts(items);
+            }
+        }
     } // End private functions
 }
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+#include <cmath>
+#include <format>
+#include <mutex>
+#include "ClockSync.hpp"
+#include "Logger.hpp"
+#include "NetStats.hpp"
+
+namespace ClockSync {
+	using std::chrono::microseconds;
+	using std::mutex;
+	using std::lock_guard;
+
+	// Private members
+	namespace {
+		double WallClockSeconds();
+
+		// Room info carries the server's clock at the moment it was sent, which is half a round trip before we read it.
+		// The shortest round trip seen is the one least inflated by queueing, so that's the one used to correct for it,
+		// the same way NTP prefers its lowest delay samples.
+		// Written by whichever thread owns the APClient and read from the game thread, so it's all behind a lock.
+		mutex clock_mutex;
+		bool synced = false;
+		double room_server_time;
+		double room_local_time;
+		Estimate estimate;
+		microseconds last_round_trip(0);
+		bool logged_estimate;
+	} // End private members
+
+
+	void ClockSync::OnRoomInfo(double server_time) {
+		lock_guard<mutex> guard(clock_mutex);
+		synced = true;
+		room_server_time = server_time;
+		room_local_time = WallClockSeconds();
+		// A new connection may take a different route, so round trips from the old one don't apply.
+		estimate = Estimate{ true, room_server_time - room_local_time, microseconds(0), microseconds(0) };
+		last_round_trip = microseconds(0);
+		logged_estimate = false;
+	}
+
+	void ClockSync::OnRoundTrip(microseconds round_trip) {
+		lock_guard<mutex> guard(clock_mutex);
+		if (!synced) {
+			return;
+		}
+		// Jitter is smoothed the same way RTP smooths interarrival jitter.
+		if (last_round_trip.count() > 0) {
+			int64_t difference = std::abs((round_trip - last_round_trip).count());
+			estimate.jitter += microseconds((difference - estimate.jitter.count()) / 16);
+		}
+		last_round_trip = round_trip;
+		if (estimate.min_round_trip.count() > 0 && round_trip >= estimate.min_round_trip) {
+			return;
+		}
+		estimate.min_round_trip = round_trip;
+		estimate.offset_seconds = room_server_time + round_trip.count() / 2000000.0 - room_local_time;
+		if (!logged_estimate) {
+			logged_estimate = true;
+			Log(std::format("Estimated server clock offset at {:+.1f}ms", estimate.offset_seconds * 1000.0));
+		}
+	}
+
+	double ClockSync::ServerNow() {
+		lock_guard<mutex> guard(clock_mutex);
+		return WallClockSeconds() + (synced ? estimate.offset_seconds : 0.0);
+	}
+
+	Estimate ClockSync::GetEstimate() {
+		lock_guard<mutex> guard(clock_mutex);
+		return estimate;
+	}
+
+	void ClockSync::PrintStats(LogType type) {
+		Estimate clock = GetEstimate();
+		if (clock.synced) {
+			Log(std::format("Server clock: offset {:+.1f}ms", clock.offset_seconds * 1000.0)
+				+ ", jitter " + NetStats::FormatMicroseconds(clock.jitter.count()), type);
+		}
+	}
+
+	void ClockSync::Reset() {
+		lock_guard<mutex> guard(clock_mutex);
+		synced = false;
+		estimate = {};
+		last_round_trip = microseconds(0);
+	}
+
+
+	// Private functions
+	namespace {
+		double WallClockSeconds() {
+			auto now = std::chrono::system_clock::now().time_since_epoch();
+			return std::chrono::duration_cast<microseconds>(now).count() / 1000000.0;
+		}
+	} // End private functions
+}
\ No newline at end of file
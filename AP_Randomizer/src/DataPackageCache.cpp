@@ -0,0 +1,175 @@
+#pragma once
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include "DataPackageCache.hpp"
+#include "Logger.hpp"
+
+namespace DataPackageCache {
+	using std::string;
+	using nlohmann::json;
+	namespace fs = std::filesystem;
+
+	// Private members
+	namespace {
+		std::map<string, string> ReadIndex();
+		void WriteIndex(const std::map<string, string>&);
+		bool ReadPackage(const fs::path&, json&);
+		bool IsValidChecksum(const string&);
+
+		// Each game's package is stored as MessagePack in a file named after its checksum,
+		// and the index maps game names to the checksum of the newest package we've seen for them.
+		// Names live in the index rather than the file names since they can contain anything.
+		const fs::path cache_directory("Mods/AP_Randomizer/dlls/datapackage");
+		const fs::path index_path = cache_directory / "index";
+		// Checksums are SHA-1 hex digests. They come from the server and become file names, so nothing else is accepted.
+		const size_t checksum_length = 40;
+		std::mutex cache_mutex;
+	} // End private members
+
+
+	json DataPackageCache::LoadChecksums() {
+		std::lock_guard<std::mutex> guard(cache_mutex);
+		json games = json::object();
+		for (const auto& [game, checksum] : ReadIndex()) {
+			// A stand-in stops the client from fetching the game, so it's only offered if there's a file to read the names from.
+			std::error_code error;
+			if (fs::file_size(cache_directory / (checksum + ".msgpack"), error) == 0 || error) {
+				continue;
+			}
+			// With empty name tables, apclientpp's get_item_name and get_location_name return "Unknown" for every cached game,
+			// so nothing should call them; names have to come from NameTable.
+			games[game] = {
+				{"checksum", checksum},
+				{"item_name_to_id", json::object()},
+				{"location_name_to_id", json::object()},
+			};
+		}
+		if (games.empty()) {
+			return nullptr;
+		}
+		Log("Found " + std::to_string(games.size()) + " cached data packages");
+		return json{ {"games", std::move(games)} };
+	}
+
+	DataPackageCache::LoadResult DataPackageCache::LoadGame(const string& game, json& package) {
+		std::lock_guard<std::mutex> guard(cache_mutex);
+		std::map<string, string> index = ReadIndex();
+		auto checksum = index.find(game);
+		if (checksum == index.end()) {
+			return LoadResult::NotCached;
+		}
+		if (ReadPackage(cache_directory / (checksum->second + ".msgpack"), package)) {
+			return LoadResult::Loaded;
+		}
+		index.erase(checksum);
+		WriteIndex(index);
+		return LoadResult::Unreadable;
+	}
+
+	void DataPackageCache::Save(const json& data_package) {
+		std::lock_guard<std::mutex> guard(cache_mutex);
+		auto games = data_package.find("games");
+		if (games == data_package.end() || !games->is_object()) {
+			return;
+		}
+
+		std::error_code error;
+		fs::create_directories(cache_directory, error);
+		std::map<string, string> index = ReadIndex();
+		int saved = 0;
+		for (const auto& [game, package] : games->items()) {
+			// Servers older than 0.4.0 don't send checksums, so there's nothing to key those packages by.
+			string checksum = package.value("checksum", "");
+			if (checksum.empty() || index[game] == checksum) {
+				continue;
+			}
+			if (!IsValidChecksum(checksum)) {
+				Log("Not caching the data package for " + game + " since its checksum isn't a SHA-1 digest", LogType::Warning);
+				continue;
+			}
+			fs::path package_path = cache_directory / (checksum + ".msgpack");
+			if (!fs::exists(package_path, error)) {
+				std::vector<uint8_t> bytes = json::to_msgpack(package);
+				std::ofstream out(package_path, std::ios::binary | std::ios::trunc);
+				out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+				if (!out) {
+					Log("Could not write data package cache for " + game, LogType::Warning);
+					continue;
+				}
+			}
+			index[game] = checksum;
+			saved++;
+		}
+		if (saved > 0) {
+			WriteIndex(index);
+			Log("Cached " + std::to_string(saved) + " data packages");
+		}
+	}
+
+
+	// Private functions
+	namespace {
+		std::map<string, string> ReadIndex() {
+			std::map<string, string> index;
+			std::ifstream in(index_path);
+			string line;
+			while (std::getline(in, line)) {
+				size_t space = line.find(' ');
+				if (space == string::npos || !IsValidChecksum(line.substr(0, space))) {
+					continue;
+				}
+				index[line.substr(space + 1)] = line.substr(0, space);
+			}
+			return index;
+		}
+
+		void WriteIndex(const std::map<string, string>& index) {
+			std::ofstream out(index_path, std::ios::trunc);
+			for (const auto& [game, checksum] : index) {
+				out << checksum << ' ' << game << '\n';
+			}
+		}
+
+		bool IsValidChecksum(const string& checksum) {
+			return checksum.size() == checksum_length && std::all_of(checksum.begin(), checksum.end(),
+				[](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+		}
+
+		// Maps the file instead of reading it so the parser can walk the bytes straight out of the page cache.
+		bool ReadPackage(const fs::path& path, json& package) {
+			HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+				CloseHandle(file);
+				return false;
+			}
+			HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+			if (mapping == nullptr) {
+				return false;
+			}
+			const uint8_t* view = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(mapping);
+			if (view == nullptr) {
+				return false;
+			}
+
+			package = json::from_msgpack(view, view + size.QuadPart, true, false);
+			UnmapViewOfFile(view);
+			if (package.is_discarded()) {
+				Log(L"Discarding corrupt data package cache file " + path.wstring(), LogType::Warning);
+				return false;
+			}
+			return true;
+		}
+	} // End private functions
+}
\ No newline at end of file
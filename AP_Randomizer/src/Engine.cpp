@@ -1,37 +1,147 @@
 #pragma once
+#include <atomic>
 #include <mutex>
-#include <queue>
+#include <algorithm>
+#include <list>
 #include "Unreal/TArray.hpp"
 #include "Unreal/World.hpp"
+#include "Unreal/UClass.hpp"
+#include "Unreal/UFunction.hpp"
+#include "Unreal/FWeakObjectPtr.hpp"
 #include "Engine.hpp"
+#include "MpscQueue.hpp"
+#include "Client.hpp"
+#include "ScoutCache.hpp"
+#include "Timer.hpp"
+#include "StringOps.hpp"
 #include "Logger.hpp"
 
 namespace Engine {
 	using namespace RC::Unreal; // Give Engine easy access to Unreal objects
-	using std::variant;
 	using std::wstring;
 	using std::to_wstring;
-	using std::shared_ptr;
 	using std::mutex;
 	using std::lock_guard;
-	using std::get;
+	using std::chrono::steady_clock;
+	using std::chrono::microseconds;
 
 	// Private members
 	namespace {
+		struct QueuedCall;
+		struct CallLane;
 		void SyncMajorKeys();
 		void SyncHealthPieces();
 		void SyncSmallKeys();
 		void SyncAbilities();
+		bool RunNextCall(CallLane&, UObject*);
+		void RunCall(QueuedCall&, UObject*);
+		void ResolveClassNames();
+		bool IsParentClass(UObject*);
+		void CacheHandles(UObject*);
+		void InvalidateHandles();
+		UObject* FindParent(size_t);
+		UFunction* FindFunction(size_t, UObject*);
+		bool AllHeldSpawnsScouted();
+		void ReleaseHeldSpawns(uint64_t);
 
-		struct BlueprintFunctionInfo {
-			variant<wstring, UObject*> parent;
-			wstring function_name;
-			shared_ptr<void> params;
+		// Where each BlueprintFunction lives and how urgent it is. Functions on the randomizer instance run on the blueprint
+		// that ticked us, and functions without a parent class run on the target they were queued with.
+		struct BlueprintFunctionName {
+			const wchar_t* parent_class;
+			const wchar_t* function_name;
+			bool on_randomizer_instance;
+			CallPriority priority;
+		};
+		const BlueprintFunctionName blueprint_function_names[] = {
+			{ L"AP_DeluxeConsole_C", L"AP_PrintToConsole", false, CallPriority::Interface },
+			{ L"BP_APRandomizerInstance_C", L"AP_PrintMessage", true, CallPriority::Interface },
+			{ L"BP_APRandomizerInstance_C", L"AP_SetHealthPieces", true, CallPriority::Gameplay },
+			{ L"BP_APRandomizerInstance_C", L"AP_SetSmallKeys", true, CallPriority::Gameplay },
+			{ L"BP_APRandomizerInstance_C", L"AP_SetMajorKeys", true, CallPriority::Gameplay },
+			{ L"BP_APRandomizerInstance_C", L"AP_SetUpgrades", true, CallPriority::Gameplay },
+			{ L"BP_APRandomizerInstance_C", L"AP_SpawnCollectible", true, CallPriority::Spawn },
+			{ L"BP_PlayerGoatMain_C", L"BPI_CombatDeath", false, CallPriority::Gameplay },
+			{ nullptr, L"Despawn", false, CallPriority::Spawn },
+		};
+		static_assert(std::size(blueprint_function_names) == static_cast<size_t>(BlueprintFunction::Count));
+
+		// Params are moved straight into the slot, so a queued call never touches the heap.
+		// The target is held weakly, since it can be destroyed in the ticks between queueing and running the call.
+		struct QueuedCall {
+			BlueprintFunction function;
+			FWeakObjectPtr target;
+			void (*destroy_params)(void*);
+			alignas(16) std::byte params[max_blueprint_params];
 		};
 
-		mutex blueprint_function_mutex;
+		// Calls are queued from the game thread, the update loop, and the network thread, and only ever run on the engine tick.
+		// Each priority has its own lane. If a lane's ring fills up, calls spill into its overflow list instead of being dropped.
+		// Once anything has spilled, new calls go there too until the tick catches up, which keeps them in order.
+		// Spilled calls are moved to the tick's own list to run, so the lock is never held across ProcessEvent.
+		struct CallLane {
+			const char* name;
+			MpscQueue<QueuedCall, 1024> ring;
+			mutex overflow_mutex;
+			std::list<QueuedCall> overflow_calls;
+			std::atomic<bool> has_overflow;
+			std::list<QueuedCall> spilled_calls;
+			// Read from the console when stats are printed.
+			std::atomic<uint64_t> queued;
+			std::atomic<uint64_t> run;
+			std::atomic<uint64_t> deferred;
+			std::atomic<uint64_t> max_depth;
+		};
+		CallLane lanes[] = {
+			{ "gameplay" },
+			{ "spawn" },
+			{ "interface" },
+		};
+		static_assert(std::size(lanes) == static_cast<size_t>(CallPriority::Count));
+		// A zone load can queue dozens of spawns on top of a console backlog, so calls are spread over as many ticks as it takes
+		// to keep each one under budget. At least one call runs every tick, so even a tiny budget can't stall the queue.
+		std::atomic<int64_t> tick_budget_us = 1000;
+		// FNames can't be built until the engine is up, so they're made on the game thread the first time something needs them.
+		// Objects constructed on the loading thread are only compared against them once they've been published.
+		FName parent_class_names[static_cast<size_t>(BlueprintFunction::Count)];
+		FName randomizer_instance_name;
+		std::atomic<bool> parent_class_names_resolved = false;
+
+		// What each BlueprintFunction last resolved to, so a call doesn't have to scan the object array or the class's functions.
+		// Filled as our blueprints are constructed and begin play, and on any miss. Everything is dropped when a new map loads.
+		// Objects and classes are held weakly, so one that's been garbage collected reads back as null instead of dangling,
+		// even if its memory has been reused. UFunctions are kept with the class they came from,
+		// so targeted calls like Despawn only hit when the target is the same class as last time.
+		// Only touched from the game thread. Blueprints can be constructed on the async loading thread too,
+		// so constructed objects are queued in constructed_objects and only cached on the next tick.
+		struct ResolvedHandle {
+			FWeakObjectPtr object;
+			FWeakObjectPtr function_class;
+			UFunction* function;
+		};
+		ResolvedHandle resolved_handles[static_cast<size_t>(BlueprintFunction::Count)];
+		// Only our own blueprints are queued, so this never comes close to filling. If it does, the next call just misses and scans.
+		MpscQueue<FWeakObjectPtr, 64> constructed_objects;
+		// Read from the console when stats are printed.
+		std::atomic<uint64_t> handle_hits;
+		std::atomic<uint64_t> handle_misses;
+		std::atomic<uint64_t> handle_invalidations;
 		bool awaiting_item_sync;
-		std::queue<BlueprintFunctionInfo> blueprint_function_queue;
+
+		// This must loop through instead of calling once with an array;
+		// as of 10/11/23 the params struct method I use can't easily represent FVectors or FTransforms in C++.
+		// This might be worked around by storing positions as three separate numbers instead and constructing the vectors in BP,
+		// but I don't think it's worth changing right now since this is just called once each map load.
+		struct CollectibleSpawnInfo {
+			int64_t new_id;
+			FVector position;
+		};
+		// A map's collectibles wait here until the scouts for them arrive, or until scout_timeout if they don't.
+		// SpawnCollectibles runs on the game thread or a timer, and scouts arrive on the update loop.
+		// Each map load bumps the generation, so a timer left over from the last map can't spawn this one's early.
+		mutex held_spawn_mutex;
+		std::vector<CollectibleSpawnInfo> held_spawns;
+		uint64_t held_spawn_generation;
+		const std::chrono::milliseconds scout_timeout(1000);
 	} // End private members
 
 
@@ -43,10 +153,32 @@ namespace Engine {
 		return GameData::MapNameToEnum(world_name);
 	}
 
-	// Queues up a blueprint function to be executed.
-	void Engine::ExecuteBlueprintFunction(variant<wstring, UObject*> new_parent, wstring new_name, shared_ptr<void> params) {
-		lock_guard<mutex> guard(blueprint_function_mutex);
-		blueprint_function_queue.push(BlueprintFunctionInfo(new_parent, new_name, params));
+	// Moves a call's params into a slot in its priority's lane, or into the lane's overflow list if the ring is full.
+	void Engine::QueueBlueprintCall(BlueprintFunction function, UObject* target, void* params,
+		void (*move_params)(void*, void*), void (*destroy_params)(void*)) {
+		CallLane& lane = lanes[static_cast<size_t>(blueprint_function_names[static_cast<size_t>(function)].priority)];
+		uint64_t depth = lane.queued.fetch_add(1, std::memory_order_relaxed) + 1 - lane.run.load(std::memory_order_relaxed);
+		uint64_t max_depth = lane.max_depth.load(std::memory_order_relaxed);
+		while (max_depth < depth && !lane.max_depth.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed)) {}
+
+		auto fill = [&](QueuedCall& call) {
+			call.function = function;
+			call.target = FWeakObjectPtr(target);
+			call.destroy_params = destroy_params;
+			if (move_params != nullptr) {
+				move_params(call.params, params);
+			}
+			};
+		if (!lane.has_overflow.load(std::memory_order_acquire) && lane.ring.TryPush(fill)) {
+			return;
+		}
+		lock_guard<mutex> guard(lane.overflow_mutex);
+		fill(lane.overflow_calls.emplace_back());
+		lane.has_overflow.store(true, std::memory_order_release);
+	}
+
+	void Engine::CallBlueprintFunction(BlueprintFunction function, UObject* target) {
+		QueueBlueprintCall(function, target, nullptr, nullptr, nullptr);
 	}
 
 	// Runs once every engine tick.
@@ -60,54 +192,83 @@ namespace Engine {
 			awaiting_item_sync = false;
 		}
 
-		// Engine tick runs in a separate thread from the client so it needs to be locked.
-		lock_guard<mutex> guard(blueprint_function_mutex);
-		while (!blueprint_function_queue.empty()) {
-			BlueprintFunctionInfo info = blueprint_function_queue.front();
-			UObject* object;
-			if (std::holds_alternative<wstring>(info.parent)) {
-				wstring parent_name = get<wstring>(info.parent);
-				object = UObjectGlobals::FindFirstOf(parent_name);
-				if (!object) {
-					Log(L"Could not find blueprint with name " + parent_name, LogType::Error);
-					blueprint_function_queue.pop();
-					continue;
-				}
+		ResolveClassNames();
+		auto cache_constructed = [](FWeakObjectPtr& constructed) {
+			if (UObject* object = constructed.Get()) {
+				CacheHandles(object);
 			}
-			else {
-				object = get<UObject*>(info.parent);
-				if (object->IsUnreachable()) {
-					Log(L"Could not call " + info.function_name + L" because the blueprint was unreachable.", LogType::Error);
-					blueprint_function_queue.pop();
-					continue;
-				}
+		};
+		while (constructed_objects.TryPop(cache_constructed)) {}
+
+		// Lanes drain in priority order until the budget runs out, and whatever's left waits for the next tick.
+		auto start = steady_clock::now();
+		microseconds budget(tick_budget_us.load(std::memory_order_relaxed));
+		bool out_of_budget = false;
+		for (CallLane& lane : lanes) {
+			while (!out_of_budget && RunNextCall(lane, blueprint)) {
+				out_of_budget = budget.count() > 0 && steady_clock::now() - start >= budget;
 			}
+		}
+		if (!out_of_budget) {
+			return;
+		}
+		for (CallLane& lane : lanes) {
+			uint64_t waiting = lane.queued.load(std::memory_order_relaxed) - lane.run.load(std::memory_order_relaxed);
+			lane.deferred.fetch_add(waiting, std::memory_order_relaxed);
+		}
+	}
+
+	void Engine::SetTickBudget(microseconds budget) {
+		tick_budget_us = budget.count();
+		if (budget.count() > 0) {
+			Log("Blueprint calls will be spread out to take at most " + std::to_string(budget.count()) + "us per frame.", LogType::System);
+		}
+		else {
+			Log(L"Every queued blueprint call will run on the next frame.", LogType::System);
+		}
+	}
 
-			UFunction* function = object->GetFunctionByName(info.function_name.c_str());
-			if (!function) {
-				Log(L"Could not find function " + info.function_name, LogType::Error);
-				blueprint_function_queue.pop();
+	// Deferred calls are summed over every tick that ran out of budget, so one call waiting three ticks counts three times.
+	void Engine::PrintStats(LogType type) {
+		for (const CallLane& lane : lanes) {
+			uint64_t queued = lane.queued;
+			uint64_t run = lane.run;
+			if (queued == 0) {
 				continue;
 			}
-			Log(L"Executing " + info.function_name);
-			// Need to cast to raw pointer to feed to ProcessEvent, but the memory will still be freed automatically
-			void* ptr(info.params.get());
-			object->ProcessEvent(function, ptr);
-			blueprint_function_queue.pop();
+			Log(std::string("Blueprint calls ") + lane.name + ": " + std::to_string(run) + " run, "
+				+ std::to_string(lane.deferred) + " deferred, " + std::to_string(queued - run) + " waiting"
+				+ ", max depth " + std::to_string(lane.max_depth), type);
+		}
+
+		if (handle_hits + handle_misses > 0) {
+			Log("Blueprint handles: " + std::to_string(handle_hits) + " hits, " + std::to_string(handle_misses) + " misses, "
+				+ std::to_string(handle_invalidations) + " map changes", type);
 		}
 	}
 
+	// A new randomizer instance beginning play means a new map, so every cached handle is stale.
+	void Engine::OnBeginPlay(UObject* actor) {
+		ResolveClassNames();
+		if (actor->GetClassPrivate()->GetNamePrivate() == randomizer_instance_name) {
+			InvalidateHandles();
+		}
+		CacheHandles(actor);
+	}
+
+	// Can run on the async loading thread, so the object is only queued here and its handles are cached on the next tick.
+	void Engine::OnObjectConstructed(UObject* object) {
+		if (!parent_class_names_resolved.load(std::memory_order_acquire) || !IsParentClass(object)) {
+			return;
+		}
+		constructed_objects.TryPush([object](FWeakObjectPtr& constructed) { constructed = FWeakObjectPtr(object); });
+	}
+
 	// Calls blueprint's AP_SpawnCollectible function for each unchecked collectible in a map.
 	void Engine::SpawnCollectibles() {
-		// This function must loop through instead of calling once with an array;
-		// as of 10/11/23 the params struct method I use can't easily represent FVectors or FTransforms in C++.
-		// This might be worked around by storing positions as three separate numbers instead and constructing the vectors in BP,
-		// but I don't think it's worth changing right now since this is just called once each map load.
-		struct CollectibleSpawnInfo {
-			int64_t new_id;
-			FVector position;
-		};
 		std::unordered_map<int64_t, GameData::Collectible> collectible_map = GameData::GetCollectiblesOfZone(GetCurrentMap());
+		std::vector<CollectibleSpawnInfo> spawns;
+		std::vector<int64_t> spawn_ids;
 		for (const auto& [id, collectible] : collectible_map) {
 			// Return if the collectible shouldn't be spawned based on options
 			if (!collectible.CanCreate(GameData::GetOptions())) {
@@ -118,10 +279,39 @@ namespace Engine {
 				Log(L"Collectible with id " + to_wstring(id) + L" has already been checked");
 				continue;
 			}
-			Log(L"Spawning collectible with id " + to_wstring(id));
-			shared_ptr<void> collectible_info(new CollectibleSpawnInfo{ id, collectible.GetPosition() });
-			ExecuteBlueprintFunction(L"BP_APRandomizerInstance_C", L"AP_SpawnCollectible", collectible_info);
+			spawn_ids.push_back(id);
+			spawns.push_back(CollectibleSpawnInfo{ id, collectible.GetPosition() });
+		}
+
+		// Scout the whole map in one request before spawning anything, rather than once per collectible.
+		// Anything scouted on an earlier visit is already cached and isn't asked for again.
+		uint64_t generation;
+		bool all_scouted;
+		{
+			lock_guard<mutex> guard(held_spawn_mutex);
+			held_spawns = std::move(spawns);
+			generation = ++held_spawn_generation;
+			all_scouted = AllHeldSpawnsScouted();
+		}
+		if (!Client::ScoutLocations(spawn_ids) || all_scouted) {
+			ReleaseHeldSpawns(generation);
+			return;
 		}
+		Timer::RunTimerRealTime(scout_timeout, [generation]() {
+			ReleaseHeldSpawns(generation);
+			});
+	}
+
+	void Engine::OnScoutsReceived() {
+		uint64_t generation;
+		{
+			lock_guard<mutex> guard(held_spawn_mutex);
+			if (held_spawns.empty() || !AllHeldSpawnsScouted()) {
+				return;
+			}
+			generation = held_spawn_generation;
+		}
+		ReleaseHeldSpawns(generation);
 	}
 
 	// Queues all item sync functions.
@@ -137,11 +327,16 @@ namespace Engine {
 
 	// Kills Sybil.
 	void Engine::VaporizeGoat() {
-		shared_ptr<void> dissolve_delay(new double(0));
-		ExecuteBlueprintFunction(L"BP_PlayerGoatMain_C", L"BPI_CombatDeath", dissolve_delay);
+		double dissolve_delay = 0;
+		CallBlueprintFunction(BlueprintFunction::CombatDeath, dissolve_delay);
 	}
 
 	void Engine::DespawnCollectible(const int64_t id) {
+		{
+			// A collectible checked while its spawn is held shouldn't spawn at all.
+			lock_guard<mutex> guard(held_spawn_mutex);
+			std::erase_if(held_spawns, [id](const CollectibleSpawnInfo& spawn) { return spawn.new_id == id; });
+		}
 		std::vector<UObject*> collectibles{};
 		UObjectGlobals::FindAllOf(STR("BP_APCollectible_C"), collectibles);
 		for (auto const collectible : collectibles) {
@@ -149,7 +344,7 @@ namespace Engine {
 			int64_t* new_id = static_cast<int64_t*>(property_ptr);
 			if (*new_id == id) {
 				Log(L"Manually despawning collectible with id " + to_wstring(id));
-				ExecuteBlueprintFunction(collectible, L"Despawn", nullptr);
+				CallBlueprintFunction(BlueprintFunction::Despawn, collectible);
 				break;
 			}
 			// It's fine if we don't find the collectible, it could just be in another map or already despawned
@@ -160,13 +355,11 @@ namespace Engine {
 	// Private functions
 	namespace {
 		void SyncHealthPieces() {
-			shared_ptr<void> hp_params(new int(GameData::GetHealthPieces()));
-			ExecuteBlueprintFunction(L"BP_APRandomizerInstance_C", L"AP_SetHealthPieces", hp_params);
+			CallBlueprintFunction(BlueprintFunction::SetHealthPieces, GameData::GetHealthPieces());
 		}
 
 		void SyncSmallKeys() {
-			shared_ptr<void> small_key_params(new int(GameData::GetSmallKeys()));
-			ExecuteBlueprintFunction(L"BP_APRandomizerInstance_C", L"AP_SetSmallKeys", small_key_params);
+			CallBlueprintFunction(BlueprintFunction::SetSmallKeys, GameData::GetSmallKeys());
 		}
 
 		void SyncMajorKeys() {
@@ -178,8 +371,7 @@ namespace Engine {
 			for (int i = 0; i < 5; i++) {
 				ue_keys.Add(major_keys[i]);
 			}
-			shared_ptr<void> major_key_params(new MajorKeyInfo{ ue_keys });
-			ExecuteBlueprintFunction(L"BP_APRandomizerInstance_C", L"AP_SetMajorKeys", major_key_params);
+			CallBlueprintFunction(BlueprintFunction::SetMajorKeys, MajorKeyInfo{ ue_keys });
 		}
 
 		void SyncAbilities() {
@@ -197,8 +389,169 @@ namespace Engine {
 				ue_names.Add(new_name);
 				ue_counts.Add(upgrade_count);
 			}
-			shared_ptr<void> upgrade_params(new AddUpgradeInfo{ ue_names, ue_counts, toggle });
-			ExecuteBlueprintFunction(L"BP_APRandomizerInstance_C", L"AP_SetUpgrades", upgrade_params);
+			CallBlueprintFunction(BlueprintFunction::SetUpgrades, AddUpgradeInfo{ ue_names, ue_counts, toggle });
+		}
+
+		// Runs the oldest call in a lane, taking it from the ring before anything that spilled over. Returns false if the lane is empty.
+		bool RunNextCall(CallLane& lane, UObject* blueprint) {
+			if (lane.ring.TryPop([blueprint](QueuedCall& call) { RunCall(call, blueprint); })) {
+				lane.run.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+			if (lane.spilled_calls.empty()) {
+				if (!lane.has_overflow.load(std::memory_order_acquire)) {
+					return false;
+				}
+				lock_guard<mutex> guard(lane.overflow_mutex);
+				lane.spilled_calls.splice(lane.spilled_calls.end(), lane.overflow_calls);
+				if (lane.spilled_calls.empty()) {
+					lane.has_overflow.store(false, std::memory_order_release);
+					return false;
+				}
+			}
+			// Run outside the lock, since a call that fails logs an error, which queues another call.
+			RunCall(lane.spilled_calls.front(), blueprint);
+			lane.spilled_calls.pop_front();
+			lane.run.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// Runs a queued call on its blueprint, then destroys its params whether or not it could run.
+		void RunCall(QueuedCall& call, UObject* randomizer_instance) {
+			size_t index = static_cast<size_t>(call.function);
+			const BlueprintFunctionName& name = blueprint_function_names[index];
+			UObject* object = nullptr;
+			if (name.on_randomizer_instance) {
+				object = randomizer_instance;
+			}
+			else if (name.parent_class != nullptr) {
+				object = FindParent(index);
+			}
+			else {
+				object = call.target.Get();
+				if (object == nullptr || object->IsUnreachable()) {
+					Log(L"Could not call " + wstring(name.function_name) + L" because the blueprint no longer exists.", LogType::Error);
+					object = nullptr;
+				}
+			}
+
+			UFunction* function = object ? FindFunction(index, object) : nullptr;
+			if (function) {
+				Log(L"Executing " + wstring(name.function_name));
+				object->ProcessEvent(function, call.destroy_params != nullptr ? call.params : nullptr);
+			}
+			if (call.destroy_params != nullptr) {
+				call.destroy_params(call.params);
+			}
+		}
+
+		// Must be called with held_spawn_mutex locked.
+		bool AllHeldSpawnsScouted() {
+			return std::all_of(held_spawns.begin(), held_spawns.end(),
+				[](const CollectibleSpawnInfo& spawn) { return ScoutCache::Find(spawn.new_id).has_value(); });
+		}
+
+		// Spawns whatever is held, unless a newer map load has replaced it since the caller looked.
+		void ReleaseHeldSpawns(uint64_t generation) {
+			std::vector<CollectibleSpawnInfo> spawns;
+			{
+				lock_guard<mutex> guard(held_spawn_mutex);
+				if (generation != held_spawn_generation) {
+					return;
+				}
+				spawns.swap(held_spawns);
+			}
+			for (const CollectibleSpawnInfo& spawn : spawns) {
+				std::optional<ScoutCache::ScoutedItem> scouted = ScoutCache::Find(spawn.new_id);
+				if (scouted) {
+					Log(L"Spawning collectible with id " + to_wstring(spawn.new_id) + L", holding "
+						+ StringOps::ToWide(scouted->item_name) + L" for " + StringOps::ToWide(scouted->player_alias));
+				}
+				else {
+					Log(L"Spawning collectible with id " + to_wstring(spawn.new_id));
+				}
+				CallBlueprintFunction(BlueprintFunction::SpawnCollectible, spawn);
+			}
+		}
+
+		void ResolveClassNames() {
+			if (parent_class_names_resolved) {
+				return;
+			}
+			for (size_t i = 0; i < std::size(blueprint_function_names); i++) {
+				if (blueprint_function_names[i].parent_class != nullptr) {
+					parent_class_names[i] = FName(blueprint_function_names[i].parent_class, FNAME_Add);
+				}
+			}
+			randomizer_instance_name = FName(STR("BP_APRandomizerInstance_C"), FNAME_Add);
+			parent_class_names_resolved.store(true, std::memory_order_release);
+		}
+
+		bool IsParentClass(UObject* object) {
+			FName class_name = object->GetClassPrivate()->GetNamePrivate();
+			return std::find(std::begin(parent_class_names), std::end(parent_class_names), class_name) != std::end(parent_class_names);
+		}
+
+		// Caches the object and its functions for every BlueprintFunction whose parent is this object's class.
+		// Class defaults and archetypes share the class but never tick, so they'd only ever be the wrong target.
+		void CacheHandles(UObject* object) {
+			if (object->HasAnyFlags(RF_ClassDefaultObject) || object->HasAnyFlags(RF_ArchetypeObject)) {
+				return;
+			}
+			UClass* object_class = object->GetClassPrivate();
+			FName class_name = object_class->GetNamePrivate();
+			for (size_t i = 0; i < std::size(blueprint_function_names); i++) {
+				if (blueprint_function_names[i].parent_class == nullptr || !(parent_class_names[i] == class_name)) {
+					continue;
+				}
+				ResolvedHandle& handle = resolved_handles[i];
+				handle.object = FWeakObjectPtr(object);
+				if (handle.function_class.Get() != object_class) {
+					handle.function = object->GetFunctionByName(blueprint_function_names[i].function_name);
+					handle.function_class = FWeakObjectPtr(object_class);
+				}
+			}
+		}
+
+		// Blueprint classes can be unloaded along with their map, so functions go too, not just objects.
+		void InvalidateHandles() {
+			for (ResolvedHandle& handle : resolved_handles) {
+				handle = {};
+			}
+			handle_invalidations++;
+		}
+
+		// Returns the cached parent of a function, falling back to a scan of the object array on a miss.
+		UObject* FindParent(size_t index) {
+			ResolvedHandle& handle = resolved_handles[index];
+			UObject* object = handle.object.Get();
+			if (object != nullptr && !object->IsUnreachable()) {
+				handle_hits++;
+				return object;
+			}
+			handle_misses++;
+			object = UObjectGlobals::FindFirstOf(parent_class_names[index]);
+			handle.object = FWeakObjectPtr(object);
+			if (!object) {
+				Log(L"Could not find blueprint with name " + wstring(blueprint_function_names[index].parent_class), LogType::Error);
+			}
+			return object;
+		}
+
+		UFunction* FindFunction(size_t index, UObject* object) {
+			ResolvedHandle& handle = resolved_handles[index];
+			UClass* object_class = object->GetClassPrivate();
+			if (handle.function != nullptr && handle.function_class.Get() == object_class) {
+				handle_hits++;
+				return handle.function;
+			}
+			handle_misses++;
+			handle.function = object->GetFunctionByName(blueprint_function_names[index].function_name);
+			handle.function_class = FWeakObjectPtr(object_class);
+			if (!handle.function) {
+				Log(L"Could not find function " + wstring(blueprint_function_names[index].function_name), LogType::Error);
+			}
+			return handle.function;
 		}
 	} // End private functions
 }
\ No newline at end of file
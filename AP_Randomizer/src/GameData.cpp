@@ -16,9 +16,12 @@ namespace GameData {
         bool major_keys[5];
         unordered_map<wstring, int> upgrade_table;
         unordered_map<Map, unordered_map<int64_t, Collectible>> collectible_table;
-        unordered_map<string, int> options;
+        Options options;
         bool slidejump_owned;
         bool slidejump_disabled;
+        // Index of the next item we expect from the server, i.e. how many items have been applied so far.
+        int next_item_index;
+        string session;
 
         const unordered_map<wstring, Map> map_names = {
             {L"TitleScreen",            Map::TitleScreen},
@@ -169,12 +172,18 @@ namespace GameData {
         return upgrade_table;
     }
 
-    void GameData::SetOption(string option_name, int value) {
-        Log("Set option " + option_name + " to " + std::to_string(value));
-        options[option_name] = value;
+    void GameData::SetOptions(const Options& new_options) {
+        options = new_options;
+        Log("Set options: slot_number " + std::to_string(options.slot_number)
+            + ", death_link " + std::to_string(options.death_link)
+            + ", logic_level " + std::to_string(options.logic_level)
+            + ", obscure_logic " + std::to_string(options.obscure_logic)
+            + ", progressive_breaker " + std::to_string(options.progressive_breaker)
+            + ", progressive_slide " + std::to_string(options.progressive_slide)
+            + ", split_sun_greaves " + std::to_string(options.split_sun_greaves));
     }
 
-    unordered_map<string, int> GameData::GetOptions() {
+    const Options& GameData::GetOptions() {
         return options;
     }
 
@@ -245,7 +254,7 @@ namespace GameData {
                     }},
             {Map::Library, unordered_map<int64_t, Collectible> {
             // Sun Greaves
-                {2365810026, Collectible(FVector(-4150, 9200, -100), vector<pair<string, int>>{{"split_sun_greaves", false}})},
+                {2365810026, Collectible(FVector(-4150, 9200, -100), vector<pair<bool Options::*, bool>>{{&Options::split_sun_greaves, false}})},
             // Upper Back
                 {2365810027, Collectible(FVector(-9250, -1850, 1250))},
             // Locked Door Across
@@ -253,11 +262,11 @@ namespace GameData {
             // Locked Door Left
                 {2365810029, Collectible(FVector(-3750, -4170, -700))},
             // Split Greaves 1
-                {2365810051, Collectible(FVector(-4150, 9160, 0), vector<pair<string, int>>{{"split_sun_greaves", true}})},
+                {2365810051, Collectible(FVector(-4150, 9160, 0), vector<pair<bool Options::*, bool>>{{&Options::split_sun_greaves, true}})},
             // Split Greaves 2
-                {2365810052, Collectible(FVector(-4100, 9250, -100), vector<pair<string, int>>{{"split_sun_greaves", true}})},
+                {2365810052, Collectible(FVector(-4100, 9250, -100), vector<pair<bool Options::*, bool>>{{&Options::split_sun_greaves, true}})},
             // Split Greaves 3
-                {2365810053, Collectible(FVector(-4200, 9250, -100), vector<pair<string, int>>{{"split_sun_greaves", true}})},
+                {2365810053, Collectible(FVector(-4200, 9250, -100), vector<pair<bool Options::*, bool>>{{&Options::split_sun_greaves, true}})},
                     }},
             {Map::Theatre, unordered_map<int64_t, Collectible> {
             // Soul Cutter
@@ -311,6 +320,30 @@ namespace GameData {
                     }},
         };
 
+        slidejump_disabled = false;
+        ResetItems();
+    }
+
+    void GameData::Close() {
+        collectible_table = {};
+        session.clear();
+        slidejump_disabled = false;
+        ResetItems();
+    }
+
+    // Initializes game data for a new seed and slot, or keeps the current data if the session hasn't changed.
+    // Returns true if the data was reset.
+    bool GameData::StartSession(string new_session) {
+        if (new_session == session) {
+            return false;
+        }
+        session = new_session;
+        Initialize();
+        return true;
+    }
+
+    // Clears every received item so the full item history can be applied again.
+    void GameData::ResetItems() {
         upgrade_table = {
             {L"attack", 0},
             {L"powerBoost", 0},
@@ -333,41 +366,20 @@ namespace GameData {
         };
 
         slidejump_owned = false;
-        slidejump_disabled = false;
+        health_pieces = 0;
         small_keys = 0;
         for (bool &k : major_keys) {
             k = false;
         }
+        next_item_index = 0;
     }
 
-    void GameData::Close() {
-        collectible_table = {};
-        slidejump_owned = false;
-        slidejump_disabled = false;
-        small_keys = 0;
-        for (bool &k : major_keys) {
-            k = false;
-        }
-        upgrade_table = {
-            {L"attack", 0},
-            {L"powerBoost", 0},
-            {L"airKick", 0},
-            {L"slide", 0},
-            {L"SlideJump", 0},
-            {L"plunge", 0},
-            {L"chargeAttack", 0},
-            {L"wallRide", 0},
-            {L"Light", 0},
-            {L"projectile", 0},
-            {L"extraKick", 0},
-            {L"airRecovery", 0},
-            {L"mobileHeal", 0},
-            {L"magicHaste", 0},
-            {L"healBoost", 0},
-            {L"damageBoost", 0},
-            {L"magicPiece", 0},
-            {L"outfitPro", 0},
-        };
+    int GameData::GetNextItemIndex() {
+        return next_item_index;
+    }
+
+    void GameData::SetNextItemIndex(int index) {
+        next_item_index = index;
     }
 
     ItemType GameData::ReceiveItem(int64_t id) {
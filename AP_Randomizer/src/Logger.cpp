@@ -24,6 +24,8 @@ namespace Logger {
 		const float popup_delay_seconds(3.2f);
 		bool messages_hidden;
 		bool messages_muted;
+		// Gates logging that is expensive to build, like dumping whole packets.
+		bool verbose;
 	} // End private members
 
 
@@ -70,18 +72,17 @@ namespace Logger {
 		} // End switch
 	}
 
-	void Logger::PrintToConsole(std::wstring markdown_text, std::wstring plain_text) {
+	void Logger::PrintToConsole(const wstring& markdown_text, const wstring& plain_text) {
 		struct ConsoleLineInfo {
 			FText markdown;
 			FText plain;
 		};
 		FText ue_markdown(markdown_text);
 		FText ue_plain(plain_text);
-		std::shared_ptr<void> params(new ConsoleLineInfo{ ue_markdown, ue_plain });
-		Engine::ExecuteBlueprintFunction(L"AP_DeluxeConsole_C", L"AP_PrintToConsole", params);
+		Engine::CallBlueprintFunction(Engine::BlueprintFunction::PrintToConsole, ConsoleLineInfo{ ue_markdown, ue_plain });
 	}
 
-	void Logger::PrintToConsole(std::wstring text) {
+	void Logger::PrintToConsole(const wstring& text) {
 		PrintToConsole(text, text);
 	}
 
@@ -98,8 +99,7 @@ namespace Logger {
 			};
 			FText new_text(message_queue.front());
 			message_queue.pop_front();
-			std::shared_ptr<void> params(new PrintToPlayerInfo{ new_text, messages_muted });
-			Engine::ExecuteBlueprintFunction(L"BP_APRandomizerInstance_C", L"AP_PrintMessage", params);
+			Engine::CallBlueprintFunction(Engine::BlueprintFunction::PrintMessage, PrintToPlayerInfo{ new_text, messages_muted });
 			Timer::RunTimerInGame(popup_delay_seconds, &popups_locked);
 		}
 	}
@@ -126,6 +126,21 @@ namespace Logger {
 	}
 
 
+	void Logger::ToggleVerbose() {
+		verbose = !verbose;
+		if (verbose) {
+			Log(L"Verbose logging is now ON.", LogType::System);
+		}
+		else {
+			Log(L"Verbose logging is now OFF.", LogType::System);
+		}
+	}
+
+	bool Logger::IsVerbose() {
+		return verbose;
+	}
+
+
 	// Private functions
 	namespace {
 		void PrintToPlayer(wstring message) {
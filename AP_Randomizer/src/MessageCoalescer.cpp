@@ -0,0 +1,93 @@
+#pragma once
+#include <mutex>
+#include "MessageCoalescer.hpp"
+#include "Logger.hpp"
+
+namespace MessageCoalescer {
+	using std::chrono::steady_clock;
+	using std::mutex;
+	using std::lock_guard;
+
+	// Private members
+	namespace {
+		struct Run {
+			int sender;
+			steady_clock::time_point opened;
+			uint64_t folded;
+		};
+
+		// Fold and TakeClosedRuns run on whichever thread owns the APClient, while the window is set from the console.
+		mutex coalescer_mutex;
+		// Windows are fixed from the first send rather than sliding, so a long release still prints a summary every window.
+		std::chrono::milliseconds window(2000);
+		// Only a handful of players release at the same time, so a flat list is plenty.
+		std::vector<Run> runs;
+		Stats stats;
+	} // End private members
+
+
+	bool MessageCoalescer::Fold(int sender, steady_clock::time_point now) {
+		lock_guard<mutex> guard(coalescer_mutex);
+		if (window.count() == 0) {
+			return false;
+		}
+		for (Run& run : runs) {
+			if (run.sender == sender && now - run.opened < window) {
+				run.folded++;
+				stats.folded++;
+				return true;
+			}
+		}
+		runs.push_back(Run{ sender, now, 0 });
+		return false;
+	}
+
+	std::vector<Summary> MessageCoalescer::TakeClosedRuns(bool close_all, steady_clock::time_point now) {
+		lock_guard<mutex> guard(coalescer_mutex);
+		std::vector<Summary> summaries;
+		if (runs.empty()) {
+			return summaries;
+		}
+		std::erase_if(runs, [&](const Run& run) {
+			if (!close_all && now - run.opened < window) {
+				return false;
+			}
+			if (run.folded > 0) {
+				summaries.push_back(Summary{ run.sender, run.folded });
+				stats.summaries++;
+			}
+			return true;
+			});
+		return summaries;
+	}
+
+	void MessageCoalescer::SetWindow(std::chrono::milliseconds new_window) {
+		lock_guard<mutex> guard(coalescer_mutex);
+		window = new_window;
+		if (window.count() > 0) {
+			Log("Item sends that don't involve you will be folded into one line per player every " + std::to_string(window.count()) + "ms.", LogType::System);
+		}
+		else {
+			Log(L"Every item send will be printed on its own.", LogType::System);
+		}
+	}
+
+	Stats MessageCoalescer::GetStats() {
+		lock_guard<mutex> guard(coalescer_mutex);
+		return stats;
+	}
+
+	void MessageCoalescer::PrintStats(LogType type) {
+		Stats messages = GetStats();
+		if (messages.folded > 0) {
+			Log("Messages: " + std::to_string(messages.folded) + " item sends folded into "
+				+ std::to_string(messages.summaries) + " summary lines", type);
+		}
+	}
+
+	void MessageCoalescer::Reset() {
+		lock_guard<mutex> guard(coalescer_mutex);
+		runs.clear();
+		stats = {};
+	}
+}
\ No newline at end of file
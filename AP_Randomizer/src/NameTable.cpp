@@ -0,0 +1,224 @@
+#pragma once
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include "NameTable.hpp"
+#include "DataPackageCache.hpp"
+#include "Recorder.hpp"
+#include "Logger.hpp"
+
+namespace NameTable {
+	using std::string;
+	using std::string_view;
+	using std::vector;
+	using nlohmann::json;
+
+	// Private members
+	namespace {
+		struct NameEntry {
+			int64_t id;
+			uint32_t offset;
+			uint32_t length;
+		};
+
+		// All of a game's names are packed back to back into one string, and each id points at its slice of it.
+		// The entries are sorted by id so lookups are a binary search over a flat array.
+		struct GameNames {
+			string arena;
+			vector<NameEntry> items;
+			vector<NameEntry> locations;
+		};
+
+		struct PlayerEntry {
+			string alias;
+			const GameNames* game;
+		};
+
+		vector<NameEntry> InternNames(const json&, string&);
+		string_view FindName(const GameNames&, const vector<NameEntry>&, int64_t);
+		const GameNames* FindGame(int);
+		const GameNames* LoadCachedGame(const string&);
+		void AttachPlayers(const string&, const GameNames*);
+
+		// Names are only interned for games someone in the room is playing, and only once they're first needed.
+		std::unordered_map<string, GameNames> games;
+		// Games we already looked for in the cache and didn't find, so a miss only hits the disk once.
+		std::unordered_set<string> uncached_games;
+		// Games from uncached_games whose cache file couldn't be read, waiting for the client to request them.
+		vector<string> games_to_fetch;
+		// Indexed by slot number. Slot 0 is always the server.
+		vector<PlayerEntry> players;
+		vector<string> player_games;
+		const string_view unknown_name("Unknown");
+		const string_view server_name("Server");
+	} // End private members
+
+
+	void NameTable::LoadDataPackage(const json& data_package) {
+		auto new_games = data_package.find("games");
+		if (new_games == data_package.end() || !new_games->is_object()) {
+			return;
+		}
+		size_t interned = 0;
+		for (const auto& [game, package] : new_games->items()) {
+			auto items = package.find("item_name_to_id");
+			auto locations = package.find("location_name_to_id");
+			bool has_items = items != package.end() && !items->empty();
+			bool has_locations = locations != package.end() && !locations->empty();
+			if (!has_items && !has_locations) {
+				continue;
+			}
+			GameNames names;
+			if (has_items) {
+				names.items = InternNames(*items, names.arena);
+			}
+			if (has_locations) {
+				names.locations = InternNames(*locations, names.arena);
+			}
+			GameNames& stored = games[game] = std::move(names);
+			uncached_games.erase(game);
+			AttachPlayers(game, &stored);
+			interned++;
+		}
+		if (interned > 0) {
+			Log("Interned names for " + std::to_string(interned) + " games");
+		}
+	}
+
+	void NameTable::SetPlayers(const vector<Player>& new_players) {
+		players.clear();
+		player_games.clear();
+		for (const auto& player : new_players) {
+			if (player.slot < 0) {
+				continue;
+			}
+			if (static_cast<size_t>(player.slot) >= players.size()) {
+				players.resize(player.slot + 1);
+				player_games.resize(player.slot + 1);
+			}
+			auto game = games.find(player.game);
+			players[player.slot] = PlayerEntry{ player.alias, game == games.end() ? nullptr : &game->second };
+			player_games[player.slot] = player.game;
+		}
+	}
+
+	string_view NameTable::GetPlayerAlias(int slot) {
+		if (slot == 0) {
+			return server_name;
+		}
+		if (slot < 0 || static_cast<size_t>(slot) >= players.size() || players[slot].alias.empty()) {
+			return unknown_name;
+		}
+		return players[slot].alias;
+	}
+
+	string_view NameTable::GetItemName(int64_t id, int player) {
+		const GameNames* game = FindGame(player);
+		if (game == nullptr) {
+			return unknown_name;
+		}
+		return FindName(*game, game->items, id);
+	}
+
+	string_view NameTable::GetLocationName(int64_t id, int player) {
+		const GameNames* game = FindGame(player);
+		if (game == nullptr) {
+			return unknown_name;
+		}
+		return FindName(*game, game->locations, id);
+	}
+
+	bool NameTable::HasNames(int player) {
+		if (player <= 0 || static_cast<size_t>(player) >= players.size() || player_games[player].empty()) {
+			// Nothing is coming for players we don't know the game of, so there's no point waiting on them.
+			return true;
+		}
+		return FindGame(player) != nullptr;
+	}
+
+	vector<string> NameTable::TakeGamesToFetch() {
+		return std::exchange(games_to_fetch, {});
+	}
+
+	void NameTable::Clear() {
+		games.clear();
+		uncached_games.clear();
+		games_to_fetch.clear();
+		players.clear();
+		player_games.clear();
+	}
+
+
+	// Private functions
+	namespace {
+		vector<NameEntry> InternNames(const json& name_to_id, string& arena) {
+			vector<NameEntry> entries;
+			entries.reserve(name_to_id.size());
+			for (const auto& [name, id] : name_to_id.items()) {
+				entries.push_back(NameEntry{ id.get<int64_t>(), static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(name.size()) });
+				arena += name;
+			}
+			std::sort(entries.begin(), entries.end(), [](const NameEntry& a, const NameEntry& b) { return a.id < b.id; });
+			return entries;
+		}
+
+		string_view FindName(const GameNames& game, const vector<NameEntry>& entries, int64_t id) {
+			auto entry = std::lower_bound(entries.begin(), entries.end(), id,
+				[](const NameEntry& e, int64_t value) { return e.id < value; });
+			if (entry == entries.end() || entry->id != id) {
+				return unknown_name;
+			}
+			return string_view(game.arena).substr(entry->offset, entry->length);
+		}
+
+		const GameNames* FindGame(int player) {
+			if (player < 0 || static_cast<size_t>(player) >= players.size()) {
+				return nullptr;
+			}
+			if (players[player].game == nullptr && !player_games[player].empty()) {
+				return LoadCachedGame(player_games[player]);
+			}
+			return players[player].game;
+		}
+
+		const GameNames* LoadCachedGame(const string& game) {
+			if (uncached_games.contains(game)) {
+				return nullptr;
+			}
+			json package;
+			DataPackageCache::LoadResult result = DataPackageCache::LoadGame(game, package);
+			if (result != DataPackageCache::LoadResult::Loaded) {
+				uncached_games.insert(game);
+				if (result == DataPackageCache::LoadResult::Unreadable) {
+					Log("Could not read cached names for " + game + ", requesting them from the server", LogType::Warning);
+					games_to_fetch.push_back(game);
+				}
+				return nullptr;
+			}
+			// Recorded as if the server had sent it so that a replay can resolve names without the cache.
+			Recorder::Record(Recorder::Direction::Inbound, "DataPackage", json{ {"games", {{game, package}}} });
+			GameNames names;
+			auto items = package.find("item_name_to_id");
+			if (items != package.end()) {
+				names.items = InternNames(*items, names.arena);
+			}
+			auto locations = package.find("location_name_to_id");
+			if (locations != package.end()) {
+				names.locations = InternNames(*locations, names.arena);
+			}
+			GameNames& stored = games[game] = std::move(names);
+			AttachPlayers(game, &stored);
+			Log("Interned cached names for " + game);
+			return &stored;
+		}
+
+		void AttachPlayers(const string& game, const GameNames* names) {
+			for (size_t slot = 0; slot < players.size(); slot++) {
+				if (player_games[slot] == game) {
+					players[slot].game = names;
+				}
+			}
+		}
+	} // End private functions
+}
\ No newline at end of file
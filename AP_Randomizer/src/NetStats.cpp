@@ -0,0 +1,272 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <format>
+#include "NetStats.hpp"
+#include "Logger.hpp"
+
+namespace NetStats {
+	using std::atomic;
+	using std::string;
+	using std::chrono::steady_clock;
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+
+	// Private members
+	namespace {
+		// Bucket 0 holds anything under 1us, bucket i holds [2^(i-1), 2^i) us, and the last bucket holds everything from ~16s up.
+		const size_t bucket_count = 26;
+		struct Histogram {
+			atomic<uint64_t> buckets[bucket_count];
+			atomic<uint64_t> count;
+			atomic<uint64_t> total_us;
+			atomic<uint64_t> max_us;
+		};
+
+		size_t BucketOf(uint64_t);
+		uint64_t Percentile(const Histogram&, double);
+		void UpdateMax(atomic<uint64_t>&, uint64_t);
+		void AddSample(Histogram&, uint64_t);
+		void ClearHistogram(Histogram&);
+
+		// Handlers run on whichever thread owns the APClient while Print runs on the console's thread, so everything is atomic.
+		Histogram handler_histograms[static_cast<size_t>(Handler::Count)];
+		// apclientpp serializes and frames commands itself, so only how many were sent is known, not how big they were.
+		atomic<uint64_t> command_counts[static_cast<size_t>(Command::Count)];
+		atomic<uint64_t> item_packets;
+		atomic<uint64_t> items_received;
+		atomic<uint64_t> largest_item_packet;
+		atomic<uint64_t> round_trip_samples;
+		atomic<uint64_t> last_round_trip_us;
+		atomic<uint64_t> smoothed_round_trip_us;
+		atomic<uint64_t> min_round_trip_us;
+		Histogram death_link_latency;
+		atomic<uint64_t> stale_death_links;
+
+		std::chrono::seconds dump_interval(0);
+		steady_clock::time_point last_dump;
+
+		const char* const handler_names[] = {
+			"poll",
+			"room_info",
+			"slot_connected",
+			"slot_refused",
+			"socket_error",
+			"items_received",
+			"location_checked",
+			"print_json",
+			"bounced",
+			"data_package",
+			"room_update",
+			"set_reply",
+			"location_info",
+		};
+		static_assert(std::size(handler_names) == static_cast<size_t>(Handler::Count));
+
+		const char* const command_names[] = {
+			"ConnectSlot",
+			"ConnectUpdate",
+			"LocationChecks",
+			"StatusUpdate",
+			"Bounce",
+			"Say",
+			"Set",
+			"Sync",
+			"Ping",
+			"LocationScouts",
+			"GetDataPackage",
+		};
+		static_assert(std::size(command_names) == static_cast<size_t>(Command::Count));
+	} // End private members
+
+
+	void NetStats::RecordHandler(Handler handler, std::chrono::nanoseconds elapsed) {
+		AddSample(handler_histograms[static_cast<size_t>(handler)], duration_cast<microseconds>(elapsed).count());
+	}
+
+	void NetStats::RecordCommand(Command command) {
+		command_counts[static_cast<size_t>(command)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void NetStats::RecordItemPacket(size_t count) {
+		item_packets.fetch_add(1, std::memory_order_relaxed);
+		items_received.fetch_add(count, std::memory_order_relaxed);
+		UpdateMax(largest_item_packet, count);
+	}
+
+	void NetStats::RecordRoundTrip(microseconds round_trip) {
+		uint64_t us = round_trip.count();
+		uint64_t samples = round_trip_samples.fetch_add(1, std::memory_order_relaxed);
+		last_round_trip_us = us;
+		if (samples == 0) {
+			smoothed_round_trip_us = us;
+			min_round_trip_us = us;
+			return;
+		}
+		// Same smoothing factor TCP uses for its RTT estimate.
+		smoothed_round_trip_us = (smoothed_round_trip_us * 7 + us) / 8;
+		if (us < min_round_trip_us) {
+			min_round_trip_us = us;
+		}
+	}
+
+	void NetStats::RecordDeathLink(microseconds latency) {
+		// The sender's clock can be slightly ahead of ours, which would make the latency negative.
+		AddSample(death_link_latency, std::max<int64_t>(latency.count(), 0));
+	}
+
+	void NetStats::RecordStaleDeathLink() {
+		stale_death_links.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	const char* NetStats::GetCommandName(Command command) {
+		return command_names[static_cast<size_t>(command)];
+	}
+
+	void NetStats::PrintStats(LogType type) {
+		Log("Network stats:", type);
+
+		if (round_trip_samples > 0) {
+			Log("Round trip: last " + FormatMicroseconds(last_round_trip_us)
+				+ ", smoothed " + FormatMicroseconds(smoothed_round_trip_us)
+				+ ", min " + FormatMicroseconds(min_round_trip_us)
+				+ " over " + std::to_string(round_trip_samples) + " samples", type);
+		}
+
+		uint64_t death_links = death_link_latency.count;
+		if (death_links > 0 || stale_death_links > 0) {
+			string latency;
+			if (death_links > 0) {
+				latency = ", latency avg " + FormatMicroseconds(death_link_latency.total_us / death_links)
+					+ ", p50 <" + FormatMicroseconds(Percentile(death_link_latency, 0.5))
+					+ ", max " + FormatMicroseconds(death_link_latency.max_us);
+			}
+			Log("DeathLinks: " + std::to_string(death_links) + " received, "
+				+ std::to_string(stale_death_links) + " stale dropped" + latency, type);
+		}
+
+		string sent;
+		for (size_t i = 0; i < static_cast<size_t>(Command::Count); i++) {
+			uint64_t count = command_counts[i];
+			if (count == 0) {
+				continue;
+			}
+			if (!sent.empty()) {
+				sent += ", ";
+			}
+			sent += string(command_names[i]) + " " + std::to_string(count);
+		}
+		if (!sent.empty()) {
+			Log("Sent: " + sent, type);
+		}
+
+		if (item_packets > 0) {
+			Log("Items: " + std::to_string(items_received) + " items over " + std::to_string(item_packets)
+				+ " packets, largest packet held " + std::to_string(largest_item_packet), type);
+		}
+
+		for (size_t i = 0; i < static_cast<size_t>(Handler::Count); i++) {
+			const Histogram& histogram = handler_histograms[i];
+			uint64_t count = histogram.count;
+			if (count == 0) {
+				continue;
+			}
+			Log(string(handler_names[i]) + ": " + std::to_string(count) + " calls"
+				+ ", avg " + FormatMicroseconds(histogram.total_us / count)
+				+ ", p50 <" + FormatMicroseconds(Percentile(histogram, 0.5))
+				+ ", p99 <" + FormatMicroseconds(Percentile(histogram, 0.99))
+				+ ", max " + FormatMicroseconds(histogram.max_us), type);
+		}
+	}
+
+	string NetStats::FormatMicroseconds(uint64_t us) {
+		if (us < 1000) {
+			return std::to_string(us) + "us";
+		}
+		if (us < 1000000) {
+			return std::format("{:.1f}ms", us / 1000.0);
+		}
+		return std::format("{:.2f}s", us / 1000000.0);
+	}
+
+	void NetStats::SetDumpInterval(std::chrono::seconds interval) {
+		dump_interval = interval;
+		last_dump = steady_clock::now();
+		if (interval.count() > 0) {
+			Log("Network stats will be written to the log every " + std::to_string(interval.count()) + " seconds.", LogType::System);
+		}
+		else {
+			Log(L"Network stats will no longer be written to the log.", LogType::System);
+		}
+	}
+
+	bool NetStats::TakeDumpDue() {
+		if (dump_interval.count() == 0 || steady_clock::now() - last_dump < dump_interval) {
+			return false;
+		}
+		last_dump = steady_clock::now();
+		return true;
+	}
+
+	void NetStats::Reset() {
+		for (Histogram& histogram : handler_histograms) {
+			ClearHistogram(histogram);
+		}
+		ClearHistogram(death_link_latency);
+		for (atomic<uint64_t>& count : command_counts) {
+			count = 0;
+		}
+		item_packets = 0;
+		items_received = 0;
+		largest_item_packet = 0;
+		round_trip_samples = 0;
+		last_round_trip_us = 0;
+		smoothed_round_trip_us = 0;
+		min_round_trip_us = 0;
+		stale_death_links = 0;
+	}
+
+
+	// Private functions
+	namespace {
+		size_t BucketOf(uint64_t us) {
+			return std::min<size_t>(std::bit_width(us), bucket_count - 1);
+		}
+
+		// Returns the upper bound of the bucket containing the given fraction of samples.
+		uint64_t Percentile(const Histogram& histogram, double fraction) {
+			uint64_t count = histogram.count.load();
+			uint64_t target = static_cast<uint64_t>(count * fraction);
+			uint64_t seen = 0;
+			for (size_t i = 0; i < bucket_count; i++) {
+				seen += histogram.buckets[i].load();
+				if (seen > target) {
+					return uint64_t{ 1 } << i;
+				}
+			}
+			return histogram.max_us.load();
+		}
+
+		void UpdateMax(atomic<uint64_t>& current, uint64_t value) {
+			uint64_t previous = current.load(std::memory_order_relaxed);
+			while (previous < value && !current.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {}
+		}
+
+		void AddSample(Histogram& histogram, uint64_t us) {
+			histogram.buckets[BucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+			histogram.count.fetch_add(1, std::memory_order_relaxed);
+			histogram.total_us.fetch_add(us, std::memory_order_relaxed);
+			UpdateMax(histogram.max_us, us);
+		}
+
+		void ClearHistogram(Histogram& histogram) {
+			for (auto& bucket : histogram.buckets) {
+				bucket = 0;
+			}
+			histogram.count = 0;
+			histogram.total_us = 0;
+			histogram.max_us = 0;
+		}
+	} // End private functions
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include "OutboundQueue.hpp"
+#include "Logger.hpp"
+#include "NetStats.hpp"
+
+namespace OutboundQueue {
+	using std::chrono::steady_clock;
+	using std::mutex;
+	using std::lock_guard;
+
+	// Private members
+	namespace {
+		struct QueuedCall {
+			std::function<void()> call;
+			steady_clock::time_point queued_at;
+		};
+
+		// A token bucket per class. Tokens refill continuously up to the burst size, and each call spends one.
+		struct PriorityClass {
+			const char* name;
+			double rate_per_second;
+			double burst;
+			size_t capacity;
+			std::deque<QueuedCall> calls;
+			double tokens;
+			steady_clock::time_point last_refill;
+			Stats stats;
+		};
+
+		void Refill(PriorityClass&, steady_clock::time_point);
+		bool TakeCall(PriorityClass&, steady_clock::time_point, QueuedCall&);
+
+		// DeathLinks, resyncs, and pings are rare, so their limit only matters if something goes wrong.
+		// Chat covers commands like !hint too, which is what a player is most likely to spam.
+		PriorityClass classes[] = {
+			{ "game", 10.0, 10.0, 64 },
+			{ "chat", 2.0, 5.0, 64 },
+			{ "storage", 5.0, 5.0, 64 },
+		};
+		static_assert(std::size(classes) == static_cast<size_t>(Priority::Count));
+
+		// Push runs on the game thread while Run runs on whichever thread owns the APClient.
+		mutex queue_mutex;
+	} // End private members
+
+
+	bool OutboundQueue::Push(Priority priority, std::function<void()> call, steady_clock::time_point now) {
+		lock_guard<mutex> guard(queue_mutex);
+		PriorityClass& priority_class = classes[static_cast<size_t>(priority)];
+		if (priority_class.calls.size() >= priority_class.capacity) {
+			priority_class.stats.dropped++;
+			Log(std::string("Dropping outbound ") + priority_class.name + " message since its queue is full", LogType::Warning);
+			return false;
+		}
+		priority_class.calls.push_back(QueuedCall{ std::move(call), now });
+		priority_class.stats.queued++;
+		priority_class.stats.max_depth = std::max(priority_class.stats.max_depth, priority_class.calls.size());
+		return true;
+	}
+
+	void OutboundQueue::Run(steady_clock::time_point now) {
+		for (PriorityClass& priority_class : classes) {
+			QueuedCall next;
+			// The lock is only held to pop, so a call is free to queue another one.
+			while (TakeCall(priority_class, now, next)) {
+				next.call();
+			}
+		}
+	}
+
+	void OutboundQueue::Clear() {
+		lock_guard<mutex> guard(queue_mutex);
+		for (PriorityClass& priority_class : classes) {
+			priority_class.calls.clear();
+		}
+	}
+
+	Stats OutboundQueue::GetStats(Priority priority) {
+		lock_guard<mutex> guard(queue_mutex);
+		const PriorityClass& priority_class = classes[static_cast<size_t>(priority)];
+		Stats stats = priority_class.stats;
+		stats.depth = priority_class.calls.size();
+		return stats;
+	}
+
+	void OutboundQueue::PrintStats(LogType type) {
+		for (size_t i = 0; i < std::size(classes); i++) {
+			Stats queue = GetStats(static_cast<Priority>(i));
+			if (queue.queued == 0) {
+				continue;
+			}
+			Log(std::string("Queue ") + classes[i].name + ": " + std::to_string(queue.sent) + " sent, "
+				+ std::to_string(queue.dropped) + " dropped, " + std::to_string(queue.depth) + " waiting"
+				+ ", max depth " + std::to_string(queue.max_depth)
+				+ ", max wait " + NetStats::FormatMicroseconds(queue.max_wait.count()), type);
+		}
+	}
+
+
+	// Private functions
+	namespace {
+		void Refill(PriorityClass& priority_class, steady_clock::time_point now) {
+			if (priority_class.last_refill == steady_clock::time_point()) {
+				priority_class.tokens = priority_class.burst;
+			}
+			else {
+				double elapsed = std::chrono::duration<double>(now - priority_class.last_refill).count();
+				priority_class.tokens = std::min(priority_class.burst, priority_class.tokens + elapsed * priority_class.rate_per_second);
+			}
+			priority_class.last_refill = now;
+		}
+
+		bool TakeCall(PriorityClass& priority_class, steady_clock::time_point now, QueuedCall& next) {
+			lock_guard<mutex> guard(queue_mutex);
+			if (priority_class.calls.empty()) {
+				return false;
+			}
+			Refill(priority_class, now);
+			if (priority_class.tokens < 1.0) {
+				return false;
+			}
+			priority_class.tokens -= 1.0;
+			next = std::move(priority_class.calls.front());
+			priority_class.calls.pop_front();
+			auto wait = std::chrono::duration_cast<std::chrono::microseconds>(now - next.queued_at);
+			priority_class.stats.sent++;
+			priority_class.stats.max_wait = std::max(priority_class.stats.max_wait, wait);
+			return true;
+		}
+	} // End private functions
+}
\ No newline at end of file
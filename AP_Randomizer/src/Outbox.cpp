@@ -0,0 +1,265 @@
+#pragma once
+#include <mutex>
+#include <set>
+#include <unordered_set>
+#include <fstream>
+#include <charconv>
+#include "Outbox.hpp"
+#include "Logger.hpp"
+
+namespace Outbox {
+	using std::list;
+	using std::string;
+	using std::mutex;
+	using std::lock_guard;
+
+	// Private members
+	namespace {
+		void AppendToJournal(const string&);
+		void ResumeJournal();
+		void RewriteJournal();
+		void CompactJournalIfDone();
+
+		// Size of [{"cmd":"LocationChecks","locations":[]}] plus a masked websocket frame header.
+		// Every check folded into an existing packet saves this minus the comma separating it from the previous id.
+		const uint64_t packet_overhead_bytes = 41 + 6;
+
+		// ReturnCheck fires on the game thread while flushes happen during on_update.
+		mutex outbox_mutex;
+		std::set<int64_t> pending_checks;
+		std::set<int64_t> sent_checks;
+		std::unordered_set<int64_t> known_checks;
+		bool goal_completed;
+		bool goal_sent;
+		Stats stats;
+
+		// The journal is a plain text file with one entry per line, starting with the session it belongs to.
+		// It's only ever appended to, except when every entry has been acknowledged and it gets truncated back to the header.
+		// A journal with an empty session was started before any slot connected, and belongs to whichever one connects first.
+		const string journal_path("Mods/AP_Randomizer/dlls/outbox");
+		std::ofstream journal;
+		string session;
+	} // End private members
+
+
+	void Outbox::OpenJournal(string new_session) {
+		lock_guard<mutex> guard(outbox_mutex);
+		journal.close();
+		session = new_session;
+
+		std::ifstream in(journal_path);
+		string line;
+		int restored = 0;
+		bool same_session = std::getline(in, line) && (line == "session " + session || line == "session ");
+		if (same_session) {
+			auto parse_id = [&line](size_t prefix_length) -> int64_t {
+				int64_t id = 0;
+				std::from_chars(line.data() + prefix_length, line.data() + line.size(), id);
+				return id;
+				};
+			while (std::getline(in, line)) {
+				if (line.starts_with("check ")) {
+					int64_t id = parse_id(6);
+					if (!known_checks.contains(id) && !sent_checks.contains(id) && pending_checks.insert(id).second) {
+						restored++;
+					}
+				}
+				else if (line.starts_with("ack ")) {
+					int64_t id = parse_id(4);
+					if (pending_checks.erase(id) > 0) {
+						restored--;
+					}
+					sent_checks.erase(id);
+				}
+				else if (line == "goal") {
+					goal_completed = true;
+				}
+				else if (line == "goal_ack") {
+					goal_completed = false;
+				}
+			}
+		}
+		in.close();
+
+		if (restored > 0 || goal_completed) {
+			Log("Restored " + std::to_string(restored) + " unsent checks from the outbox journal"
+				+ (goal_completed ? " along with goal completion." : "."));
+		}
+		RewriteJournal();
+	}
+
+	bool Outbox::QueueCheck(int64_t id) {
+		lock_guard<mutex> guard(outbox_mutex);
+		if (known_checks.contains(id)) {
+			stats.already_checked++;
+			return false;
+		}
+		if (sent_checks.contains(id) || !pending_checks.insert(id).second) {
+			stats.duplicates_dropped++;
+			return false;
+		}
+		stats.checks_queued++;
+		AppendToJournal("check " + std::to_string(id));
+		return true;
+	}
+
+	void Outbox::MarkChecked(int64_t id) {
+		lock_guard<mutex> guard(outbox_mutex);
+		known_checks.insert(id);
+		// Only journal acknowledgements for checks we actually sent, since the server reports every checked location on connect.
+		bool was_outstanding = pending_checks.erase(id) + sent_checks.erase(id) > 0;
+		if (was_outstanding) {
+			AppendToJournal("ack " + std::to_string(id));
+			CompactJournalIfDone();
+		}
+	}
+
+	bool Outbox::HasPendingChecks() {
+		lock_guard<mutex> guard(outbox_mutex);
+		return !pending_checks.empty();
+	}
+
+	list<int64_t> Outbox::TakePendingChecks() {
+		lock_guard<mutex> guard(outbox_mutex);
+		list<int64_t> batch(pending_checks.begin(), pending_checks.end());
+		if (batch.empty()) {
+			return batch;
+		}
+		sent_checks.insert(pending_checks.begin(), pending_checks.end());
+		pending_checks.clear();
+
+		uint64_t folded = batch.size() - 1;
+		stats.packets_sent++;
+		stats.packets_saved += folded;
+		stats.bytes_saved += folded * (packet_overhead_bytes - 1);
+		if (folded > 0) {
+			Log("Batched " + std::to_string(batch.size()) + " checks into one packet ("
+				+ std::to_string(stats.packets_saved) + " packets and "
+				+ std::to_string(stats.bytes_saved) + " bytes saved this session)");
+		}
+		return batch;
+	}
+
+	void Outbox::QueueGoal() {
+		lock_guard<mutex> guard(outbox_mutex);
+		if (goal_completed) {
+			return;
+		}
+		goal_completed = true;
+		AppendToJournal("goal");
+	}
+
+	bool Outbox::TakeGoal() {
+		lock_guard<mutex> guard(outbox_mutex);
+		if (!goal_completed || goal_sent) {
+			return false;
+		}
+		goal_sent = true;
+		return true;
+	}
+
+	void Outbox::ConfirmGoal() {
+		lock_guard<mutex> guard(outbox_mutex);
+		if (!goal_completed) {
+			return;
+		}
+		goal_completed = false;
+		AppendToJournal("goal_ack");
+		CompactJournalIfDone();
+	}
+
+	void Outbox::OnConnect() {
+		lock_guard<mutex> guard(outbox_mutex);
+		known_checks.clear();
+		pending_checks.insert(sent_checks.begin(), sent_checks.end());
+		sent_checks.clear();
+		goal_sent = false;
+	}
+
+	void Outbox::Reset() {
+		lock_guard<mutex> guard(outbox_mutex);
+		journal.close();
+		session.clear();
+		pending_checks.clear();
+		sent_checks.clear();
+		known_checks.clear();
+		goal_completed = false;
+		goal_sent = false;
+		stats = {};
+	}
+
+	Stats Outbox::GetStats() {
+		lock_guard<mutex> guard(outbox_mutex);
+		return stats;
+	}
+
+	void Outbox::PrintStats(LogType type) {
+		Stats outbox = GetStats();
+		Log("Outbox: " + std::to_string(outbox.checks_queued) + " checks queued, "
+			+ std::to_string(outbox.duplicates_dropped) + " duplicates dropped, "
+			+ std::to_string(outbox.already_checked) + " already checked, "
+			+ std::to_string(outbox.packets_sent) + " packets sent, "
+			+ std::to_string(outbox.packets_saved) + " packets and " + std::to_string(outbox.bytes_saved) + " B saved", type);
+	}
+
+
+	// Private functions
+	namespace {
+		// Flushes to the OS after every entry but doesn't force a disk sync; losing power mid-seed is rare enough.
+		void AppendToJournal(const string& entry) {
+			if (!journal.is_open()) {
+				ResumeJournal();
+			}
+			if (!journal.is_open()) {
+				return;
+			}
+			journal << entry << '\n';
+			journal.flush();
+		}
+
+		// Reopens the journal under the session that last wrote it, so checks made before connecting survive a crash too.
+		// If a different slot connects, OpenJournal drops the file and rewrites what's in memory under the new session.
+		void ResumeJournal() {
+			std::ifstream in(journal_path);
+			string line;
+			bool has_header = std::getline(in, line) && line.starts_with("session ");
+			in.close();
+			session = has_header ? line.substr(8) : "";
+			journal.open(journal_path, std::ios::out | (has_header ? std::ios::app : std::ios::trunc));
+			if (!journal.is_open()) {
+				Log("Could not open the outbox journal; checks will not survive a restart.", LogType::Warning);
+				return;
+			}
+			if (!has_header) {
+				journal << "session " << session << '\n';
+			}
+		}
+
+		// Truncates the journal and writes out everything that's still unacknowledged.
+		void RewriteJournal() {
+			journal.close();
+			journal.open(journal_path, std::ios::out | std::ios::trunc);
+			if (!journal.is_open()) {
+				Log("Could not open the outbox journal; checks will not survive a restart.", LogType::Warning);
+				return;
+			}
+			journal << "session " << session << '\n';
+			for (const int64_t id : sent_checks) {
+				journal << "check " << id << '\n';
+			}
+			for (const int64_t id : pending_checks) {
+				journal << "check " << id << '\n';
+			}
+			if (goal_completed) {
+				journal << "goal\n";
+			}
+			journal.flush();
+		}
+
+		void CompactJournalIfDone() {
+			if (journal.is_open() && pending_checks.empty() && sent_checks.empty() && !goal_completed) {
+				RewriteJournal();
+			}
+		}
+	} // End private functions
+}
\ No newline at end of file
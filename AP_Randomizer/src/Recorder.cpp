@@ -0,0 +1,142 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include "Recorder.hpp"
+#include "Logger.hpp"
+
+namespace Recorder {
+	using std::string;
+	using std::vector;
+	using nlohmann::json;
+	namespace fs = std::filesystem;
+
+	// Private members
+	namespace {
+		void WriteLength(uint32_t);
+		uint32_t ReadLength(const vector<uint8_t>&, size_t);
+
+		// A recording is the header followed by frames, each stored as a little-endian length
+		// and then a MessagePack array of [time_us, direction, kind, payload].
+		const fs::path recording_directory("Mods/AP_Randomizer/dlls/recordings");
+		const string header("APREC1\n");
+
+		// Recording only starts and stops while no network thread is running,
+		// so every frame is written by whichever thread owns the APClient at the time.
+		std::ofstream recording;
+		std::chrono::steady_clock::time_point recording_start;
+		uint64_t frames_written;
+		vector<uint8_t> frame_buffer;
+	} // End private members
+
+
+	void Recorder::Start() {
+		Stop();
+		std::error_code error;
+		fs::create_directories(recording_directory, error);
+		auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+		fs::path path = recording_directory / std::format("{:%Y%m%d-%H%M%S}.aprec", now);
+		recording.open(path, std::ios::binary | std::ios::trunc);
+		if (!recording) {
+			Log(L"Could not open recording " + path.wstring(), LogType::Warning);
+			return;
+		}
+		recording << header;
+		recording_start = std::chrono::steady_clock::now();
+		frames_written = 0;
+		Log(L"Recording session to " + path.wstring(), LogType::System);
+	}
+
+	void Recorder::Stop() {
+		if (!recording.is_open()) {
+			return;
+		}
+		recording.close();
+		Log("Stopped recording after " + std::to_string(frames_written) + " frames", LogType::System);
+	}
+
+	bool Recorder::IsRecording() {
+		return recording.is_open();
+	}
+
+	void Recorder::Record(Direction direction, std::string_view kind, const json& payload) {
+		if (!recording.is_open()) {
+			return;
+		}
+		auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - recording_start);
+		frame_buffer.clear();
+		json::to_msgpack(json::array({ elapsed.count(), static_cast<uint8_t>(direction), kind, payload }), frame_buffer);
+		WriteLength(static_cast<uint32_t>(frame_buffer.size()));
+		recording.write(reinterpret_cast<const char*>(frame_buffer.data()), frame_buffer.size());
+		// Flushed per frame so that a recording of a crash still has everything leading up to it.
+		recording.flush();
+		frames_written++;
+	}
+
+	bool Recorder::Load(const string& name, vector<Frame>& frames) {
+		std::error_code error;
+		fs::path path(name);
+		if (!fs::exists(path, error)) {
+			path = recording_directory / name;
+		}
+		std::ifstream in(path, std::ios::binary);
+		if (!in) {
+			Log(L"Could not open recording " + path.wstring(), LogType::System);
+			return false;
+		}
+		vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		if (bytes.size() < header.size() || !std::equal(header.begin(), header.end(), bytes.begin())) {
+			Log(L"Not a recording: " + path.wstring(), LogType::System);
+			return false;
+		}
+
+		frames.clear();
+		size_t offset = header.size();
+		while (offset + sizeof(uint32_t) <= bytes.size()) {
+			uint32_t length = ReadLength(bytes, offset);
+			offset += sizeof(uint32_t);
+			if (offset + length > bytes.size()) {
+				// The last frame was cut off, most likely because the game closed mid-write.
+				break;
+			}
+			json frame = json::from_msgpack(bytes.begin() + offset, bytes.begin() + offset + length, true, false);
+			offset += length;
+			if (frame.is_discarded() || !frame.is_array() || frame.size() != 4
+				|| !frame[0].is_number_integer() || !frame[1].is_number_unsigned() || !frame[2].is_string()) {
+				Log(L"Skipping corrupt frame in " + path.wstring(), LogType::Warning);
+				continue;
+			}
+			frames.push_back(Frame{
+				frame[0].get<int64_t>(),
+				static_cast<Direction>(frame[1].get<uint8_t>()),
+				frame[2].get<string>(),
+				std::move(frame[3]),
+				});
+		}
+		Log(L"Loaded " + std::to_wstring(frames.size()) + L" frames from " + path.wstring());
+		return true;
+	}
+
+
+	// Private functions
+	namespace {
+		void WriteLength(uint32_t length) {
+			char bytes[4] = {
+				static_cast<char>(length & 0xFF),
+				static_cast<char>((length >> 8) & 0xFF),
+				static_cast<char>((length >> 16) & 0xFF),
+				static_cast<char>((length >> 24) & 0xFF),
+			};
+			recording.write(bytes, sizeof(bytes));
+		}
+
+		uint32_t ReadLength(const vector<uint8_t>& bytes, size_t offset) {
+			return static_cast<uint32_t>(bytes[offset])
+				| static_cast<uint32_t>(bytes[offset + 1]) << 8
+				| static_cast<uint32_t>(bytes[offset + 2]) << 16
+				| static_cast<uint32_t>(bytes[offset + 3]) << 24;
+		}
+	} // End private functions
+}
\ No newline at end of file
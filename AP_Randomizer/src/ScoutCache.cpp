@@ -0,0 +1,84 @@
+#pragma once
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
+#include "ScoutCache.hpp"
+#include "Logger.hpp"
+
+namespace ScoutCache {
+	using std::vector;
+	using std::mutex;
+	using std::lock_guard;
+
+	// Private members
+	namespace {
+		vector<ScoutedItem>::iterator LowerBound(int64_t);
+
+		// Spawning asks from the game thread while replies are stored from the update loop.
+		mutex scout_mutex;
+		// Sorted by location so lookups are a binary search over a flat array.
+		// A map only holds a few dozen collectibles, so inserting into the middle is cheap.
+		vector<ScoutedItem> scouted;
+		std::unordered_set<int64_t> requested;
+	} // End private members
+
+
+	vector<int64_t> ScoutCache::TakeUnscouted(const vector<int64_t>& locations) {
+		lock_guard<mutex> guard(scout_mutex);
+		vector<int64_t> unscouted;
+		for (const int64_t location : locations) {
+			auto iter = LowerBound(location);
+			if (iter != scouted.end() && iter->location == location) {
+				continue;
+			}
+			if (requested.insert(location).second) {
+				unscouted.push_back(location);
+			}
+		}
+		return unscouted;
+	}
+
+	void ScoutCache::Store(const vector<ScoutedItem>& items) {
+		lock_guard<mutex> guard(scout_mutex);
+		for (const ScoutedItem& item : items) {
+			requested.erase(item.location);
+			auto iter = LowerBound(item.location);
+			if (iter != scouted.end() && iter->location == item.location) {
+				*iter = item;
+			}
+			else {
+				scouted.insert(iter, item);
+			}
+		}
+		Log("Scout cache now holds " + std::to_string(scouted.size()) + " locations");
+	}
+
+	std::optional<ScoutedItem> ScoutCache::Find(int64_t location) {
+		lock_guard<mutex> guard(scout_mutex);
+		auto iter = LowerBound(location);
+		if (iter == scouted.end() || iter->location != location) {
+			return {};
+		}
+		return *iter;
+	}
+
+	void ScoutCache::ForgetRequests() {
+		lock_guard<mutex> guard(scout_mutex);
+		requested.clear();
+	}
+
+	void ScoutCache::Clear() {
+		lock_guard<mutex> guard(scout_mutex);
+		scouted.clear();
+		requested.clear();
+	}
+
+
+	// Private functions
+	namespace {
+		vector<ScoutedItem>::iterator LowerBound(int64_t location) {
+			return std::lower_bound(scouted.begin(), scouted.end(), location,
+				[](const ScoutedItem& item, int64_t id) { return item.location < id; });
+		}
+	} // End private functions
+}
\ No newline at end of file
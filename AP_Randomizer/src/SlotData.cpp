@@ -0,0 +1,104 @@
+#pragma once
+#include "valijson/adapters/nlohmann_json_adapter.hpp"
+#include "valijson/schema.hpp"
+#include "valijson/schema_parser.hpp"
+#include "valijson/validator.hpp"
+#include "SlotData.hpp"
+#include "Logger.hpp"
+
+namespace SlotData {
+	using nlohmann::json;
+	using std::string;
+
+	// Private members
+	namespace {
+		const valijson::Schema& GetSchema();
+
+		// Mirrors fill_slot_data in the apworld. Unknown keys are allowed so that newer apworlds can add options
+		// without breaking older clients, but every option the client reads has to be present and well-typed.
+		const char* const slot_data_schema = R"({
+			"type": "object",
+			"properties": {
+				"slot_number": { "type": "integer", "minimum": 1 },
+				"death_link": { "type": "boolean" },
+				"logic_level": { "type": "integer", "minimum": 1, "maximum": 4 },
+				"obscure_logic": { "type": "boolean" },
+				"progressive_breaker": { "type": "boolean" },
+				"progressive_slide": { "type": "boolean" },
+				"split_sun_greaves": { "type": "boolean" }
+			},
+			"required": [
+				"death_link",
+				"logic_level",
+				"obscure_logic",
+				"progressive_breaker",
+				"progressive_slide",
+				"split_sun_greaves"
+			]
+		})";
+	} // End private members
+
+
+	bool SlotData::Parse(const json& slot_data, GameData::Options& options) {
+		valijson::Validator validator;
+		valijson::ValidationResults results;
+		valijson::adapters::NlohmannJsonAdapter target(slot_data);
+		bool valid = validator.validate(GetSchema(), target, &results);
+		if (!valid) {
+			valijson::ValidationResults::Error error;
+			while (results.popError(error)) {
+				string context;
+				for (const string& part : error.context) {
+					context += part;
+				}
+				Log("Slot data error at " + context + ": " + error.description, LogType::Warning);
+			}
+		}
+
+		// Read leniently so a seed from a slightly different apworld still gets as many options as possible.
+		auto read_bool = [&slot_data](const char* key, bool fallback) -> bool {
+			auto value = slot_data.find(key);
+			if (value == slot_data.end()) {
+				return fallback;
+			}
+			if (value->is_boolean()) {
+				return value->get<bool>();
+			}
+			return value->is_number() && value->get<int>() != 0;
+			};
+		auto read_int = [&slot_data](const char* key, int fallback) -> int {
+			auto value = slot_data.find(key);
+			if (value == slot_data.end() || !value->is_number()) {
+				return fallback;
+			}
+			return value->get<int>();
+			};
+
+		GameData::Options defaults;
+		options.slot_number = read_int("slot_number", defaults.slot_number);
+		options.death_link = read_bool("death_link", defaults.death_link);
+		options.logic_level = read_int("logic_level", defaults.logic_level);
+		options.obscure_logic = read_bool("obscure_logic", defaults.obscure_logic);
+		options.progressive_breaker = read_bool("progressive_breaker", defaults.progressive_breaker);
+		options.progressive_slide = read_bool("progressive_slide", defaults.progressive_slide);
+		options.split_sun_greaves = read_bool("split_sun_greaves", defaults.split_sun_greaves);
+		return valid;
+	}
+
+
+	// Private functions
+	namespace {
+		// The schema only needs to be compiled once per process.
+		const valijson::Schema& GetSchema() {
+			static valijson::Schema schema;
+			static const bool populated = []() {
+				valijson::SchemaParser parser;
+				json schema_document = json::parse(slot_data_schema);
+				valijson::adapters::NlohmannJsonAdapter schema_adapter(schema_document);
+				parser.populateSchema(schema_adapter, schema);
+				return true;
+				}();
+			return schema;
+		}
+	} // End private functions
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <codecvt>
+#include <locale>
 #include <algorithm>
 #include "StringOps.hpp"
 
@@ -16,4 +17,66 @@ namespace StringOps {
 		static std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
 		return converter.from_bytes(input);
 	}
+
+	void AppendWide(wstring& output, std::string_view input) {
+		const wchar_t replacement = 0xFFFD;
+		size_t i = 0;
+		while (i < input.size()) {
+			unsigned char lead = input[i];
+			if (lead < 0x80) {
+				output.push_back(lead);
+				i++;
+				continue;
+			}
+
+			// The smallest code point each length may encode. Anything below it is an overlong encoding.
+			char32_t code_point;
+			char32_t minimum;
+			size_t length;
+			if ((lead & 0xE0) == 0xC0) {
+				code_point = lead & 0x1F;
+				minimum = 0x80;
+				length = 2;
+			}
+			else if ((lead & 0xF0) == 0xE0) {
+				code_point = lead & 0x0F;
+				minimum = 0x800;
+				length = 3;
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4) {
+				code_point = lead & 0x07;
+				minimum = 0x10000;
+				length = 4;
+			}
+			else {
+				output.push_back(replacement);
+				i++;
+				continue;
+			}
+
+			bool valid = i + length <= input.size();
+			for (size_t k = 1; valid && k < length; k++) {
+				unsigned char continuation = input[i + k];
+				valid = (continuation & 0xC0) == 0x80;
+				code_point = (code_point << 6) | (continuation & 0x3F);
+			}
+			// Surrogates only exist in UTF-16, so an encoded one would turn into half of a bogus pair.
+			valid = valid && code_point >= minimum && code_point <= 0x10FFFF && (code_point < 0xD800 || code_point > 0xDFFF);
+			if (!valid) {
+				output.push_back(replacement);
+				i++;
+				continue;
+			}
+			i += length;
+
+			if (code_point >= 0x10000) {
+				code_point -= 0x10000;
+				output.push_back(static_cast<wchar_t>(0xD800 + (code_point >> 10)));
+				output.push_back(static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF)));
+			}
+			else {
+				output.push_back(static_cast<wchar_t>(code_point));
+			}
+		}
+	}
 }
\ No newline at end of file
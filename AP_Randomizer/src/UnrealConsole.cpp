@@ -1,11 +1,15 @@
 #pragma once
 #include <optional>
 #include <cwctype>
+#include <charconv>
 #include "boost/algorithm/string.hpp"
 #include "UnrealConsole.hpp"
 #include "Client.hpp"
 #include "Logger.hpp"
 #include "StringOps.hpp"
+#include "NetStats.hpp"
+#include "MessageCoalescer.hpp"
+#include "Engine.hpp"
 
 namespace UnrealConsole {
 	using std::string;
@@ -26,6 +30,15 @@ namespace UnrealConsole {
 		constexpr size_t getitem = HashWstring(L"getitem");
 		constexpr size_t popups = HashWstring(L"popups");
 		constexpr size_t countdown = HashWstring(L"countdown");
+		constexpr size_t networkthread = HashWstring(L"networkthread");
+		constexpr size_t verbose = HashWstring(L"verbose");
+		constexpr size_t netstats = HashWstring(L"netstats");
+		constexpr size_t record = HashWstring(L"record");
+		constexpr size_t replay = HashWstring(L"replay");
+		constexpr size_t heartbeat = HashWstring(L"heartbeat");
+		constexpr size_t coalesce = HashWstring(L"coalesce");
+		constexpr size_t tickbudget = HashWstring(L"tickbudget");
+		constexpr size_t deathlinkage = HashWstring(L"deathlinkage");
 	}
 
 	// Private members
@@ -34,6 +47,7 @@ namespace UnrealConsole {
 		void ParseMessageOption(string);
 		void TryConnect(wstring);
 		string GetNextToken(string&);
+		bool ParseNonNegative(string, int&);
 		string ConvertTcharToString(const TCHAR*);
 		string ConvertWstringToString(wstring);
 
@@ -132,12 +146,101 @@ namespace UnrealConsole {
 			}
 			break;
 		}
+		case Hashes::networkthread:
+			Logger::PrintToConsole(L"/" + input);
+			Client::ToggleNetworkThread();
+			break;
+		case Hashes::verbose:
+			Logger::PrintToConsole(L"/" + input);
+			Logger::ToggleVerbose();
+			break;
+		case Hashes::netstats: {
+			Logger::PrintToConsole(L"/" + input);
+			string interval_args = StringOps::ToNarrow(args);
+			boost::algorithm::trim(interval_args);
+			if (interval_args.empty()) {
+				Client::PrintStats(LogType::System);
+				break;
+			}
+			int seconds;
+			if (!ParseNonNegative(interval_args, seconds)) {
+				Log(L"Please input either \"/netstats\" or \"/netstats <seconds>\", where 0 stops logging stats.", LogType::System);
+				break;
+			}
+			NetStats::SetDumpInterval(std::chrono::seconds(seconds));
+			break;
+		}
+		case Hashes::record:
+			Logger::PrintToConsole(L"/" + input);
+			Client::ToggleRecording();
+			break;
+		case Hashes::replay: {
+			Logger::PrintToConsole(L"/" + input);
+			string replay_args = StringOps::ToNarrow(args);
+			string file = GetNextToken(replay_args);
+			if (file.empty()) {
+				Log(L"Please input \"/replay <recording>\", optionally followed by \"realtime\".", LogType::System);
+				break;
+			}
+			boost::algorithm::trim(replay_args);
+			boost::algorithm::to_lower(replay_args);
+			Client::Replay(file, replay_args == "realtime");
+			break;
+		}
+		case Hashes::heartbeat: {
+			Logger::PrintToConsole(L"/" + input);
+			string heartbeat_args = StringOps::ToNarrow(args);
+			string seconds_token = GetNextToken(heartbeat_args);
+			string missed_token = GetNextToken(heartbeat_args);
+			int seconds;
+			int missed_limit = 3;
+			bool valid = ParseNonNegative(seconds_token, seconds) && seconds > 0;
+			if (valid && !missed_token.empty()) {
+				valid = ParseNonNegative(missed_token, missed_limit);
+			}
+			if (!valid) {
+				Log(L"Please input \"/heartbeat <seconds> <missed>\", where missed is how many unanswered heartbeats reset the connection (0 never does).", LogType::System);
+				break;
+			}
+			Client::SetHeartbeat(seconds, missed_limit);
+			break;
+		}
+		case Hashes::coalesce: {
+			Logger::PrintToConsole(L"/" + input);
+			int milliseconds;
+			if (!ParseNonNegative(StringOps::ToNarrow(args), milliseconds)) {
+				Log(L"Please input \"/coalesce <milliseconds>\", where 0 prints every item send on its own.", LogType::System);
+				break;
+			}
+			MessageCoalescer::SetWindow(std::chrono::milliseconds(milliseconds));
+			break;
+		}
+		case Hashes::tickbudget: {
+			Logger::PrintToConsole(L"/" + input);
+			int microseconds;
+			if (!ParseNonNegative(StringOps::ToNarrow(args), microseconds)) {
+				Log(L"Please input \"/tickbudget <microseconds>\", where 0 runs every queued blueprint call at once.", LogType::System);
+				break;
+			}
+			Engine::SetTickBudget(std::chrono::microseconds(microseconds));
+			break;
+		}
+		case Hashes::deathlinkage: {
+			Logger::PrintToConsole(L"/" + input);
+			int seconds;
+			if (!ParseNonNegative(StringOps::ToNarrow(args), seconds)) {
+				Log(L"Please input \"/deathlinkage <seconds>\", where 0 accepts DeathLinks no matter how old they are.", LogType::System);
+				break;
+			}
+			Client::SetDeathLinkMaxAge(seconds);
+			break;
+		}
 		default:
 			Logger::PrintToConsole(L"/" + input);
 			Log(L"Command not recognized: " + input, LogType::System);
 			Log(L"Known commands: "
 				"connect, disconnect, release, collect, hint, hint_location, "
-				"remaining, missing, checked, getitem, popups, countdown", LogType::System);
+				"remaining, missing, checked, getitem, popups, countdown, networkthread, verbose, netstats, record, replay, heartbeat, coalesce, tickbudget, deathlinkage", LogType::System);
 			break;
 		}
 	}
@@ -299,5 +402,17 @@ namespace UnrealConsole {
 			input.erase(0, input.find(DELIM));
 			return token;
 		}
+
+		// Reads a whole argument as a non-negative number, ignoring surrounding spaces. Anything else leaves value untouched.
+		bool ParseNonNegative(string input, int& value) {
+			boost::algorithm::trim(input);
+			int parsed = -1;
+			auto [end, error] = std::from_chars(input.data(), input.data() + input.size(), parsed);
+			if (error != std::errc() || end != input.data() + input.size() || parsed < 0) {
+				return false;
+			}
+			value = parsed;
+			return true;
+		}
 	} // End private functions
 }
\ No newline at end of file
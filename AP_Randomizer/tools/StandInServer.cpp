@@ -0,0 +1,579 @@
+// A stand-in Archipelago server for soak testing the client without a real host.
+// It only speaks the part of the protocol the client uses, and floods it with synthetic traffic from a script.
+//
+// Usage: StandInServer [port] [script]
+//
+// A script is a list of lines, where # starts a comment:
+//   players 500
+//   phase 30 items=20 batch=5 chat=100 sends=400 deathlinks=0.5
+//   phase 60 chat=1000
+// Rates are per second. The last phase repeats until the server is closed.
+#define ASIO_STANDALONE
+#define _WEBSOCKETPP_CPP11_STL_
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "websocketpp/config/asio_no_tls.hpp"
+#include "websocketpp/server.hpp"
+#include "nlohmann/json.hpp"
+
+namespace StandInServer {
+	using std::string;
+	using std::vector;
+	using nlohmann::json;
+	typedef websocketpp::server<websocketpp::config::asio> Server;
+	typedef websocketpp::connection_hdl Handle;
+
+	// Private members
+	namespace {
+		struct Phase {
+			double seconds = 0;
+			double items = 0;
+			int batch = 1;
+			double chat = 0;
+			double sends = 0;
+			double deathlinks = 0;
+		};
+
+		struct Session {
+			bool connected = false;
+			bool death_link = false;
+			vector<json> items;
+			// Fractional amounts left over from previous ticks, so low rates still fire eventually.
+			double items_due = 0;
+			double chat_due = 0;
+			double sends_due = 0;
+			double deathlinks_due = 0;
+		};
+
+		struct Counters {
+			uint64_t frames_sent = 0;
+			uint64_t commands_sent = 0;
+			uint64_t bytes_sent = 0;
+			uint64_t frames_received = 0;
+			uint64_t bytes_received = 0;
+		};
+
+		bool LoadScript(const string&);
+		void OnOpen(Handle);
+		void OnClose(Handle);
+		void OnMessage(Handle, Server::message_ptr);
+		void HandleCommand(Handle, Session&, const json&, json&);
+		void Tick();
+		void Generate(Session&, const Phase&, double, json&);
+		void ScheduleTick();
+		void Send(Handle, const json&);
+		json RoomInfo();
+		json Connected();
+		json DataPackage(const json&);
+		json MakeItem(int64_t, int64_t, int, unsigned);
+		json PlayerNode(int);
+		string Alias(int);
+		string GameOf(int);
+		double Now();
+		int RandomOtherSlot();
+
+		const string game_name("Pseudoregalia");
+		const int own_slot = 1;
+		const int synthetic_game_count = 8;
+		const int synthetic_item_count = 200;
+		const int synthetic_location_count = 500;
+		const int64_t first_location_id = 2365810001;
+		const int location_count = 53;
+		// Health pieces are the only item that can be received any number of times without changing how the game plays.
+		const int64_t health_piece_id = 2365810019;
+		const std::chrono::milliseconds tick_interval(10);
+
+		// Pseudoregalia's items, so the client can name what it receives.
+		const std::map<string, int64_t> item_ids = {
+			{"Dream Breaker", 2365810001}, {"Indignation", 2365810002}, {"Sun Greaves", 2365810003},
+			{"Slide", 2365810004}, {"Solar Wind", 2365810005}, {"Sunsetter", 2365810006},
+			{"Strikebreak", 2365810007}, {"Cling Gem", 2365810008}, {"Ascendant Light", 2365810009},
+			{"Soul Cutter", 2365810010}, {"Heliacal Power", 2365810011}, {"Aerial Finesse", 2365810012},
+			{"Pilgrimage", 2365810013}, {"Empathy", 2365810014}, {"Good Graces", 2365810015},
+			{"Martial Prowess", 2365810016}, {"Clear Mind", 2365810017}, {"Professionalism", 2365810018},
+			{"Health Piece", 2365810019}, {"Small Key", 2365810020}, {"Major Key - Empty Bailey", 2365810021},
+			{"Major Key - The Underbelly", 2365810022}, {"Major Key - Tower Remains", 2365810023},
+			{"Major Key - Sansa Keep", 2365810024}, {"Major Key - Twilight Theatre", 2365810025},
+			{"Progressive Slide", 2365810026}, {"Air Kick", 2365810027}, {"Progressive Dream Breaker", 2365810028},
+		};
+
+		Server server;
+		std::map<Handle, Session, std::owner_less<Handle>> sessions;
+		std::unique_ptr<asio::steady_timer> tick_timer;
+		std::mt19937 random(1234);
+
+		int player_count = 500;
+		vector<Phase> phases = { Phase{ 0, 10, 5, 50, 200, 0.2 } };
+		size_t phase_index = 0;
+		std::chrono::steady_clock::time_point phase_start;
+		std::chrono::steady_clock::time_point last_tick;
+		std::chrono::steady_clock::time_point last_report;
+		Counters counters;
+		std::set<int64_t> checked_locations;
+		std::map<string, json> data_storage;
+	} // End private members
+
+
+	int Run(int argc, char** argv) {
+		uint16_t port = 38281;
+		if (argc > 1) {
+			port = static_cast<uint16_t>(std::stoi(argv[1]));
+		}
+		if (argc > 2 && !LoadScript(argv[2])) {
+			return 1;
+		}
+
+		server.init_asio();
+		server.set_reuse_addr(true);
+		server.clear_access_channels(websocketpp::log::alevel::all);
+		server.set_open_handler(OnOpen);
+		server.set_close_handler(OnClose);
+		server.set_message_handler(OnMessage);
+		server.listen(port);
+		server.start_accept();
+
+		tick_timer = std::make_unique<asio::steady_timer>(server.get_io_service());
+		phase_start = last_tick = last_report = std::chrono::steady_clock::now();
+		ScheduleTick();
+		std::printf("Stand-in server listening on ws://localhost:%u with %d players and %zu phases\n",
+			port, player_count, phases.size());
+		server.run();
+		return 0;
+	}
+
+
+	// Private functions
+	namespace {
+		bool LoadScript(const string& path) {
+			std::ifstream in(path);
+			if (!in) {
+				std::fprintf(stderr, "Could not open script %s\n", path.c_str());
+				return false;
+			}
+			phases.clear();
+			string line;
+			int line_number = 0;
+			while (std::getline(in, line)) {
+				line_number++;
+				line = line.substr(0, line.find('#'));
+				std::istringstream words(line);
+				string keyword;
+				if (!(words >> keyword)) {
+					continue;
+				}
+				if (keyword == "players") {
+					words >> player_count;
+					player_count = std::max(player_count, own_slot);
+					continue;
+				}
+				if (keyword != "phase") {
+					std::fprintf(stderr, "%s:%d: unknown keyword %s\n", path.c_str(), line_number, keyword.c_str());
+					return false;
+				}
+				Phase phase;
+				words >> phase.seconds;
+				string setting;
+				while (words >> setting) {
+					size_t equals = setting.find('=');
+					if (equals == string::npos) {
+						std::fprintf(stderr, "%s:%d: expected key=value, got %s\n", path.c_str(), line_number, setting.c_str());
+						return false;
+					}
+					string key = setting.substr(0, equals);
+					double value = std::stod(setting.substr(equals + 1));
+					if (key == "items") {
+						phase.items = value;
+					}
+					else if (key == "batch") {
+						phase.batch = std::max(1, static_cast<int>(value));
+					}
+					else if (key == "chat") {
+						phase.chat = value;
+					}
+					else if (key == "sends") {
+						phase.sends = value;
+					}
+					else if (key == "deathlinks") {
+						phase.deathlinks = value;
+					}
+					else {
+						std::fprintf(stderr, "%s:%d: unknown setting %s\n", path.c_str(), line_number, key.c_str());
+						return false;
+					}
+				}
+				phases.push_back(phase);
+			}
+			if (phases.empty()) {
+				phases.push_back(Phase{});
+			}
+			return true;
+		}
+
+		void OnOpen(Handle handle) {
+			sessions[handle] = Session{};
+			Send(handle, json::array({ RoomInfo() }));
+			std::printf("Client connected\n");
+		}
+
+		void OnClose(Handle handle) {
+			sessions.erase(handle);
+			std::printf("Client disconnected\n");
+		}
+
+		void OnMessage(Handle handle, Server::message_ptr message) {
+			counters.frames_received++;
+			counters.bytes_received += message->get_payload().size();
+			auto session = sessions.find(handle);
+			if (session == sessions.end()) {
+				return;
+			}
+			json commands = json::parse(message->get_payload(), nullptr, false);
+			if (commands.is_discarded() || !commands.is_array()) {
+				std::printf("Ignoring malformed frame: %s\n", message->get_payload().c_str());
+				return;
+			}
+			json replies = json::array();
+			for (const auto& command : commands) {
+				HandleCommand(handle, session->second, command, replies);
+			}
+			if (!replies.empty()) {
+				Send(handle, replies);
+			}
+		}
+
+		void HandleCommand(Handle handle, Session& session, const json& command, json& replies) {
+			string cmd = command.value("cmd", "");
+			if (cmd == "GetDataPackage") {
+				replies.push_back(DataPackage(command.value("games", json::array())));
+			}
+			else if (cmd == "Connect") {
+				if (command.value("game", "") != game_name) {
+					replies.push_back({ {"cmd", "ConnectionRefused"}, {"errors", {"InvalidGame"}} });
+					return;
+				}
+				json tags = command.value("tags", json::array());
+				session.connected = true;
+				session.death_link = std::find(tags.begin(), tags.end(), "DeathLink") != tags.end();
+				replies.push_back(Connected());
+				replies.push_back({ {"cmd", "ReceivedItems"}, {"index", 0}, {"items", session.items} });
+			}
+			else if (cmd == "ConnectUpdate") {
+				json tags = command.value("tags", json::array());
+				session.death_link = std::find(tags.begin(), tags.end(), "DeathLink") != tags.end();
+			}
+			else if (cmd == "Sync") {
+				replies.push_back({ {"cmd", "ReceivedItems"}, {"index", 0}, {"items", session.items} });
+			}
+			else if (cmd == "LocationChecks") {
+				json newly_checked = json::array();
+				for (const auto& location : command.value("locations", json::array())) {
+					int64_t id = location.get<int64_t>();
+					if (!checked_locations.insert(id).second) {
+						continue;
+					}
+					newly_checked.push_back(id);
+					int receiver = RandomOtherSlot();
+					json item = MakeItem(std::uniform_int_distribution<int64_t>(1, synthetic_item_count)(random), id, own_slot, 0);
+					replies.push_back({
+						{"cmd", "PrintJSON"}, {"type", "ItemSend"}, {"receiving", receiver}, {"item", item},
+						{"data", {
+							PlayerNode(own_slot), {{"text", " sent "}},
+							{{"type", "item_id"}, {"text", std::to_string(item["item"].get<int64_t>())}, {"player", receiver}, {"flags", 0}},
+							{{"text", " to "}}, PlayerNode(receiver), {{"text", " ("}},
+							{{"type", "location_id"}, {"text", std::to_string(id)}, {"player", own_slot}}, {{"text", ")"}},
+						}},
+						});
+				}
+				if (!newly_checked.empty()) {
+					replies.push_back({ {"cmd", "RoomUpdate"}, {"checked_locations", newly_checked} });
+				}
+			}
+			else if (cmd == "LocationScouts") {
+				json scouted = json::array();
+				for (const auto& location : command.value("locations", json::array())) {
+					int64_t item_id = std::uniform_int_distribution<int64_t>(1, synthetic_item_count)(random);
+					scouted.push_back(MakeItem(item_id, location.get<int64_t>(), RandomOtherSlot(), 0));
+				}
+				replies.push_back({ {"cmd", "LocationInfo"}, {"locations", scouted} });
+			}
+			else if (cmd == "Set") {
+				string key = command.value("key", "");
+				json original = data_storage.count(key) ? data_storage[key] : command.value("default", json());
+				json value = original;
+				for (const auto& operation : command.value("operations", json::array())) {
+					string type = operation.value("operation", "");
+					if (type == "replace") {
+						value = operation["value"];
+					}
+					else if (type == "add" && value.is_number() && operation["value"].is_number()) {
+						value = value.get<double>() + operation["value"].get<double>();
+					}
+				}
+				data_storage[key] = value;
+				if (command.value("want_reply", false)) {
+					replies.push_back({ {"cmd", "SetReply"}, {"key", key}, {"value", value}, {"original_value", original}, {"slot", own_slot} });
+				}
+			}
+			else if (cmd == "Bounce") {
+				// There's only ever one real client, so a bounce either comes straight back to it or goes nowhere.
+				json slots = command.value("slots", json::array());
+				json tags = command.value("tags", json::array());
+				bool to_us = std::find(slots.begin(), slots.end(), own_slot) != slots.end()
+					|| (session.death_link && std::find(tags.begin(), tags.end(), "DeathLink") != tags.end());
+				if (to_us) {
+					json bounced = command;
+					bounced["cmd"] = "Bounced";
+					replies.push_back(bounced);
+				}
+			}
+			else if (cmd == "Say") {
+				string text = command.value("text", "");
+				replies.push_back({ {"cmd", "PrintJSON"}, {"type", "Chat"}, {"team", 0}, {"slot", own_slot}, {"message", text},
+					{"data", { {{"text", Alias(own_slot) + ": " + text}} }} });
+			}
+			else if (cmd == "StatusUpdate") {
+				std::printf("Client status is now %d\n", command.value("status", 0));
+			}
+			else {
+				std::printf("Ignoring %s\n", cmd.c_str());
+			}
+		}
+
+		void Tick() {
+			auto now = std::chrono::steady_clock::now();
+			double elapsed = std::chrono::duration<double>(now - last_tick).count();
+			last_tick = now;
+
+			const Phase& phase = phases[phase_index];
+			if (phase.seconds > 0 && std::chrono::duration<double>(now - phase_start).count() >= phase.seconds
+				&& phase_index + 1 < phases.size()) {
+				phase_index++;
+				phase_start = now;
+				std::printf("Starting phase %zu\n", phase_index + 1);
+			}
+
+			for (auto& [handle, session] : sessions) {
+				if (!session.connected) {
+					continue;
+				}
+				// Everything generated for this tick goes out as one frame, the same way the server batches broadcasts.
+				json frame = json::array();
+				Generate(session, phases[phase_index], elapsed, frame);
+				if (!frame.empty()) {
+					Send(handle, frame);
+				}
+			}
+
+			if (now - last_report >= std::chrono::seconds(1)) {
+				double seconds = std::chrono::duration<double>(now - last_report).count();
+				std::printf("sent %.0f frames/s, %.0f commands/s, %.1f KB/s; received %.0f frames/s, %.1f KB/s\n",
+					counters.frames_sent / seconds, counters.commands_sent / seconds, counters.bytes_sent / seconds / 1024,
+					counters.frames_received / seconds, counters.bytes_received / seconds / 1024);
+				counters = Counters{};
+				last_report = now;
+			}
+			ScheduleTick();
+		}
+
+		void Generate(Session& session, const Phase& phase, double elapsed, json& frame) {
+			session.items_due += phase.items * elapsed;
+			session.chat_due += phase.chat * elapsed;
+			session.sends_due += phase.sends * elapsed;
+			session.deathlinks_due += phase.deathlinks * elapsed;
+
+			while (session.items_due >= 1) {
+				int batch = std::min(phase.batch, static_cast<int>(session.items_due));
+				session.items_due -= batch;
+				json items = json::array();
+				for (int i = 0; i < batch; i++) {
+					int sender = RandomOtherSlot();
+					int64_t location = std::uniform_int_distribution<int64_t>(1, synthetic_location_count)(random);
+					items.push_back(MakeItem(health_piece_id, location, sender, 0));
+				}
+				frame.push_back({ {"cmd", "ReceivedItems"}, {"index", session.items.size()}, {"items", items} });
+				session.items.insert(session.items.end(), items.begin(), items.end());
+			}
+			while (session.chat_due >= 1) {
+				session.chat_due -= 1;
+				int speaker = RandomOtherSlot();
+				frame.push_back({ {"cmd", "PrintJSON"}, {"type", "Chat"}, {"team", 0}, {"slot", speaker}, {"message", "Hello from the stand-in server"},
+					{"data", { {{"text", Alias(speaker) + ": Hello from the stand-in server"}} }} });
+			}
+			while (session.sends_due >= 1) {
+				session.sends_due -= 1;
+				int sender = RandomOtherSlot();
+				int receiver = RandomOtherSlot();
+				int64_t item_id = std::uniform_int_distribution<int64_t>(1, synthetic_item_count)(random);
+				int64_t location = std::uniform_int_distribution<int64_t>(1, synthetic_location_count)(random);
+				unsigned flags = std::uniform_int_distribution<unsigned>(0, 4)(random) & 0b111;
+				frame.push_back({
+					{"cmd", "PrintJSON"}, {"type", "ItemSend"}, {"receiving", receiver}, {"item", MakeItem(item_id, location, sender, flags)},
+					{"data", {
+						PlayerNode(sender), {{"text", " sent "}},
+						{{"type", "item_id"}, {"text", std::to_string(item_id)}, {"player", receiver}, {"flags", flags}},
+						{{"text", " to "}}, PlayerNode(receiver), {{"text", " ("}},
+						{{"type", "location_id"}, {"text", std::to_string(location)}, {"player", sender}}, {{"text", ")"}},
+					}},
+					});
+			}
+			while (session.deathlinks_due >= 1) {
+				session.deathlinks_due -= 1;
+				if (!session.death_link) {
+					continue;
+				}
+				string source = Alias(RandomOtherSlot());
+				frame.push_back({ {"cmd", "Bounced"}, {"tags", {"DeathLink"}},
+					{"data", { {"time", Now()}, {"source", source}, {"cause", source + " was flattened by the stand-in server."} }} });
+			}
+		}
+
+		void ScheduleTick() {
+			tick_timer->expires_after(tick_interval);
+			tick_timer->async_wait([](const asio::error_code& error) {
+				if (!error) {
+					Tick();
+				}
+				});
+		}
+
+		void Send(Handle handle, const json& commands) {
+			string payload = commands.dump();
+			websocketpp::lib::error_code error;
+			server.send(handle, payload, websocketpp::frame::opcode::text, error);
+			if (error) {
+				std::printf("Send failed: %s\n", error.message().c_str());
+				return;
+			}
+			counters.frames_sent++;
+			counters.commands_sent += commands.size();
+			counters.bytes_sent += payload.size();
+		}
+
+		// Checksums are left out on purpose so the client never caches these packages over real ones.
+		json RoomInfo() {
+			json games = json::array({ game_name });
+			for (int i = 0; i < synthetic_game_count; i++) {
+				games.push_back("Synthetic " + std::to_string(i));
+			}
+			return {
+				{"cmd", "RoomInfo"},
+				{"version", {{"major", 0}, {"minor", 5}, {"build", 0}, {"class", "Version"}}},
+				{"generator_version", {{"major", 0}, {"minor", 5}, {"build", 0}, {"class", "Version"}}},
+				{"tags", {"AP"}},
+				{"password", false},
+				{"permissions", {{"release", 2}, {"collect", 2}, {"remaining", 2}}},
+				{"hint_cost", 10},
+				{"location_check_points", 1},
+				{"games", games},
+				{"datapackage_checksums", json::object()},
+				{"seed_name", "StandIn" + std::to_string(player_count)},
+				{"time", Now()},
+			};
+		}
+
+		json Connected() {
+			json players = json::array();
+			json slot_info = json::object();
+			for (int slot = 1; slot <= player_count; slot++) {
+				players.push_back({ {"team", 0}, {"slot", slot}, {"alias", Alias(slot)}, {"name", Alias(slot)}, {"class", "NetworkPlayer"} });
+				slot_info[std::to_string(slot)] = { {"name", Alias(slot)}, {"game", GameOf(slot)}, {"type", 1}, {"group_members", json::array()}, {"class", "NetworkSlot"} };
+			}
+			json missing_locations = json::array();
+			for (int i = 0; i < location_count; i++) {
+				if (!checked_locations.count(first_location_id + i)) {
+					missing_locations.push_back(first_location_id + i);
+				}
+			}
+			return {
+				{"cmd", "Connected"},
+				{"team", 0},
+				{"slot", own_slot},
+				{"players", players},
+				{"missing_locations", missing_locations},
+				{"checked_locations", checked_locations},
+				{"slot_data", {
+					{"slot_number", own_slot},
+					{"death_link", true},
+					{"logic_level", 1},
+					{"obscure_logic", false},
+					{"progressive_breaker", false},
+					{"progressive_slide", false},
+					{"split_sun_greaves", false},
+				}},
+				{"slot_info", slot_info},
+				{"hint_points", 0},
+			};
+		}
+
+		json DataPackage(const json& requested) {
+			json games = json::object();
+			for (const auto& game : requested) {
+				string name = game.get<string>();
+				json items = json::object();
+				json locations = json::object();
+				if (name == game_name) {
+					for (const auto& [item, id] : item_ids) {
+						items[item] = id;
+					}
+					for (int i = 0; i < location_count; i++) {
+						locations["Location " + std::to_string(i + 1)] = first_location_id + i;
+					}
+				}
+				else {
+					for (int i = 1; i <= synthetic_item_count; i++) {
+						items[name + " Item " + std::to_string(i)] = i;
+					}
+					for (int i = 1; i <= synthetic_location_count; i++) {
+						locations[name + " Location " + std::to_string(i)] = i;
+					}
+				}
+				games[name] = { {"item_name_to_id", items}, {"location_name_to_id", locations} };
+			}
+			return { {"cmd", "DataPackage"}, {"data", {{"games", games}}} };
+		}
+
+		json MakeItem(int64_t item, int64_t location, int player, unsigned flags) {
+			return { {"item", item}, {"location", location}, {"player", player}, {"flags", flags}, {"class", "NetworkItem"} };
+		}
+
+		json PlayerNode(int slot) {
+			return { {"type", "player_id"}, {"text", std::to_string(slot)} };
+		}
+
+		string Alias(int slot) {
+			return "Player" + std::to_string(slot);
+		}
+
+		string GameOf(int slot) {
+			if (slot == own_slot) {
+				return game_name;
+			}
+			return "Synthetic " + std::to_string(slot % synthetic_game_count);
+		}
+
+		double Now() {
+			return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+		}
+
+		int RandomOtherSlot() {
+			if (player_count <= own_slot) {
+				return own_slot;
+			}
+			return std::uniform_int_distribution<int>(own_slot + 1, player_count)(random);
+		}
+	} // End private functions
+}
+
+int main(int argc, char** argv) {
+	return StandInServer::Run(argc, argv);
+}
\ No newline at end of file
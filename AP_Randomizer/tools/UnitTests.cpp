@@ -0,0 +1,649 @@
+// Unit tests for the parts of the client that don't need the game or a server.
+// Each test runs against the real module, with Logger stubbed out, in a scratch directory so journals and caches start empty.
+//
+// Usage: UnitTests
+// Prints every failed check and exits with 1 if there were any.
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "ClockSync.hpp"
+#include "DataPackageCache.hpp"
+#include "Logger.hpp"
+#include "MessageCoalescer.hpp"
+#include "MpscQueue.hpp"
+#include "NameTable.hpp"
+#include "OutboundQueue.hpp"
+#include "Outbox.hpp"
+#include "SlotData.hpp"
+#include "SpscQueue.hpp"
+#include "StringOps.hpp"
+
+#define CHECK(condition) UnitTests::Check((condition), #condition, __FILE__, __LINE__)
+
+// Nothing here runs inside the game, so logging goes nowhere.
+namespace Logger {
+	void Log(std::wstring, LogType) {}
+	void Log(std::string, LogType) {}
+	bool IsVerbose() {
+		return false;
+	}
+	void PrintToConsole(const std::wstring&, const std::wstring&) {}
+	void PrintToConsole(const std::wstring&) {}
+}
+
+namespace UnitTests {
+	using std::string;
+	using std::wstring;
+	using std::vector;
+	using nlohmann::json;
+	using std::chrono::steady_clock;
+	using std::chrono::milliseconds;
+	using std::chrono::microseconds;
+	namespace fs = std::filesystem;
+
+	// Private members
+	namespace {
+		struct Test {
+			const char* name;
+			void (*run)();
+		};
+
+		void TestOutboxBatching();
+		void TestOutboxJournal();
+		void TestSpscQueue();
+		void TestDataPackageCache();
+		void TestNameTable();
+		void TestAppendWide();
+		void TestSlotData();
+		void TestOutboundQueue();
+		void TestClockSync();
+		void TestMessageCoalescer();
+		void TestMpscQueue();
+		vector<int64_t> TakePendingChecks();
+		double WallClockSeconds();
+		bool Near(double, double, double);
+
+		const Test tests[] = {
+			{ "OutboxBatching", TestOutboxBatching },
+			{ "OutboxJournal", TestOutboxJournal },
+			{ "SpscQueue", TestSpscQueue },
+			{ "DataPackageCache", TestDataPackageCache },
+			{ "NameTable", TestNameTable },
+			{ "AppendWide", TestAppendWide },
+			{ "SlotData", TestSlotData },
+			{ "OutboundQueue", TestOutboundQueue },
+			{ "ClockSync", TestClockSync },
+			{ "MessageCoalescer", TestMessageCoalescer },
+			{ "MpscQueue", TestMpscQueue },
+		};
+		int failures = 0;
+		const char* current_test = "";
+	} // End private members
+
+
+	void Check(bool passed, const char* expression, const char* file, int line) {
+		if (passed) {
+			return;
+		}
+		failures++;
+		std::cerr << "[" << current_test << "] " << file << ":" << line << ": CHECK(" << expression << ") failed" << std::endl;
+	}
+
+	int Run() {
+		// The journal and the data package cache live at fixed paths relative to the game's working directory.
+		fs::path scratch = fs::temp_directory_path() / "AP_Randomizer_UnitTests";
+		fs::remove_all(scratch);
+		fs::create_directories(scratch / "Mods/AP_Randomizer/dlls");
+		fs::current_path(scratch);
+
+		for (const Test& test : tests) {
+			current_test = test.name;
+			int failures_before = failures;
+			test.run();
+			std::cout << (failures == failures_before ? "PASS " : "FAIL ") << test.name << std::endl;
+		}
+
+		fs::current_path(fs::temp_directory_path());
+		fs::remove_all(scratch);
+		std::cout << failures << " failed checks" << std::endl;
+		return failures == 0 ? 0 : 1;
+	}
+
+
+	// Private functions
+	namespace {
+		void TestOutboxBatching() {
+			Outbox::Reset();
+			Outbox::OpenJournal("batching slot");
+			CHECK(!Outbox::HasPendingChecks());
+			CHECK(Outbox::QueueCheck(1));
+			CHECK(Outbox::QueueCheck(2));
+			CHECK(Outbox::QueueCheck(3));
+			// A collectible picked up twice in one frame is only sent once.
+			CHECK(!Outbox::QueueCheck(2));
+			CHECK(Outbox::HasPendingChecks());
+			CHECK((TakePendingChecks() == vector<int64_t>{ 1, 2, 3 }));
+			CHECK(!Outbox::HasPendingChecks());
+
+			// Sent but unacknowledged checks are still duplicates, and so are ones the server says are done.
+			CHECK(!Outbox::QueueCheck(3));
+			Outbox::MarkChecked(2);
+			CHECK(!Outbox::QueueCheck(2));
+			CHECK(!Outbox::HasPendingChecks());
+
+			Outbox::Stats stats = Outbox::GetStats();
+			CHECK(stats.checks_queued == 3);
+			CHECK(stats.duplicates_dropped == 2);
+			CHECK(stats.already_checked == 1);
+			// Three checks went out in one packet instead of three.
+			CHECK(stats.packets_sent == 1);
+			CHECK(stats.packets_saved == 2);
+			Outbox::Reset();
+		}
+
+		void TestOutboxJournal() {
+			Outbox::Reset();
+			Outbox::OpenJournal("seed slot");
+			CHECK(Outbox::QueueCheck(1));
+			CHECK(Outbox::QueueCheck(2));
+			CHECK(Outbox::QueueCheck(3));
+			CHECK((TakePendingChecks() == vector<int64_t>{ 1, 2, 3 }));
+			Outbox::MarkChecked(2);
+			Outbox::QueueGoal();
+
+			// A crash loses memory but not the journal, so reopening it brings back whatever wasn't acknowledged.
+			Outbox::Reset();
+			CHECK(!Outbox::HasPendingChecks());
+			Outbox::OpenJournal("seed slot");
+			CHECK((TakePendingChecks() == vector<int64_t>{ 1, 3 }));
+			CHECK(Outbox::TakeGoal());
+			CHECK(!Outbox::TakeGoal());
+
+			// Reconnecting requeues what was in flight, and the server's checked locations clear it.
+			Outbox::OnConnect();
+			CHECK(Outbox::TakeGoal());
+			Outbox::MarkChecked(1);
+			Outbox::MarkChecked(3);
+			Outbox::ConfirmGoal();
+			CHECK(!Outbox::HasPendingChecks());
+			Outbox::Reset();
+			Outbox::OpenJournal("seed slot");
+			CHECK(!Outbox::HasPendingChecks());
+			CHECK(!Outbox::TakeGoal());
+
+			// Checks made before connecting are journaled under the last session, and kept if that slot connects again.
+			Outbox::Reset();
+			CHECK(Outbox::QueueCheck(7));
+			Outbox::Reset();
+			Outbox::OpenJournal("seed slot");
+			CHECK((TakePendingChecks() == vector<int64_t>{ 7 }));
+
+			// A different slot's journal is thrown away.
+			Outbox::Reset();
+			Outbox::OpenJournal("other slot");
+			CHECK(!Outbox::HasPendingChecks());
+			Outbox::Reset();
+		}
+
+		void TestSpscQueue() {
+			Client::SpscQueue<int, 4> queue;
+			for (int i = 0; i < 4; i++) {
+				CHECK(queue.TryPush(int(i)));
+			}
+			CHECK(!queue.TryPush(4));
+			CHECK(queue.Size() == 4);
+			int value = -1;
+			CHECK(queue.TryPop(value) && value == 0);
+			CHECK(queue.TryPush(4));
+			for (int i = 1; i <= 4; i++) {
+				CHECK(queue.TryPop(value) && value == i);
+			}
+			CHECK(!queue.TryPop(value));
+
+			// Everything pushed on one thread comes out on the other, in order, across many laps of the ring.
+			const int count = 200000;
+			Client::SpscQueue<int, 64> shared;
+			std::thread producer([&shared]() {
+				for (int i = 0; i < count; i++) {
+					while (!shared.TryPush(int(i))) {
+						std::this_thread::yield();
+					}
+				}
+				});
+			int expected = 0;
+			bool in_order = true;
+			while (expected < count) {
+				if (shared.TryPop(value)) {
+					in_order = in_order && value == expected;
+					expected++;
+				}
+			}
+			producer.join();
+			CHECK(in_order);
+			CHECK(shared.Size() == 0);
+		}
+
+		void TestDataPackageCache() {
+			using DataPackageCache::LoadResult;
+			CHECK(DataPackageCache::LoadChecksums().is_null());
+
+			json data_package = {
+				{"games", {
+					{"Cached Game", {
+						{"checksum", "0123456789abcdef0123456789abcdef01234567"},
+						{"item_name_to_id", {{"Thing", 5}}},
+						{"location_name_to_id", {{"Place", 6}}},
+					}},
+					// Checksums become file names, so anything that isn't a SHA-1 digest is never cached.
+					{"Bad Checksum Game", {
+						{"checksum", "0123456789ABCDEF0123456789ABCDEF01234567"},
+						{"item_name_to_id", {{"Other Thing", 5}}},
+						{"location_name_to_id", json::object()},
+					}},
+					// Servers older than 0.4.0 don't send checksums at all.
+					{"Old Server Game", {
+						{"item_name_to_id", {{"Old Thing", 5}}},
+						{"location_name_to_id", json::object()},
+					}},
+				}},
+			};
+			DataPackageCache::Save(data_package);
+			json package;
+			CHECK(DataPackageCache::LoadGame("Cached Game", package) == LoadResult::Loaded);
+			CHECK(package["item_name_to_id"].value("Thing", 0) == 5);
+			CHECK(package["location_name_to_id"].value("Place", 0) == 6);
+			CHECK(DataPackageCache::LoadGame("Bad Checksum Game", package) == LoadResult::NotCached);
+			CHECK(DataPackageCache::LoadGame("Old Server Game", package) == LoadResult::NotCached);
+
+			// Stand-ins only carry the checksum, so the client skips fetching the game without holding its names.
+			json checksums = DataPackageCache::LoadChecksums();
+			CHECK(checksums["games"].size() == 1);
+			const json& stand_in = checksums["games"]["Cached Game"];
+			CHECK(stand_in["checksum"] == "0123456789abcdef0123456789abcdef01234567");
+			CHECK(stand_in["item_name_to_id"].empty());
+			CHECK(stand_in["location_name_to_id"].empty());
+
+			// A package with a new checksum replaces the old one.
+			data_package["games"]["Cached Game"]["checksum"] = "89abcdef0123456789abcdef0123456789abcdef";
+			data_package["games"]["Cached Game"]["item_name_to_id"]["Thing"] = 7;
+			DataPackageCache::Save(data_package);
+			CHECK(DataPackageCache::LoadGame("Cached Game", package) == LoadResult::Loaded);
+			CHECK(package["item_name_to_id"].value("Thing", 0) == 7);
+			CHECK(DataPackageCache::LoadChecksums()["games"]["Cached Game"]["checksum"] == "89abcdef0123456789abcdef0123456789abcdef");
+
+			fs::remove_all("Mods/AP_Randomizer/dlls/datapackage");
+		}
+
+		void TestNameTable() {
+			NameTable::Clear();
+			json data_package = {
+				{"games", {
+					{"Pseudoregalia", {
+						{"checksum", "0123456789abcdef0123456789abcdef01234567"},
+						{"item_name_to_id", {{"Dream Breaker", 2365810001}, {"Slide", 2365810002}}},
+						{"location_name_to_id", {{"Dilapidated Dungeon - Dream Breaker", 2365810001}}},
+					}},
+					// Cache stand-ins only carry a checksum and are skipped.
+					{"Stand-in Game", {
+						{"checksum", "89abcdef0123456789abcdef0123456789abcdef"},
+						{"item_name_to_id", json::object()},
+						{"location_name_to_id", json::object()},
+					}},
+				}},
+			};
+			NameTable::LoadDataPackage(data_package);
+			NameTable::SetPlayers({
+				{ 1, "Sybil", "Pseudoregalia" },
+				{ 2, "Other", "Stand-in Game" },
+				});
+
+			CHECK(NameTable::GetPlayerAlias(0) == "Server");
+			CHECK(NameTable::GetPlayerAlias(1) == "Sybil");
+			CHECK(NameTable::GetPlayerAlias(9) == "Unknown");
+			CHECK(NameTable::GetItemName(2365810001, 1) == "Dream Breaker");
+			CHECK(NameTable::GetItemName(2365810002, 1) == "Slide");
+			CHECK(NameTable::GetItemName(2365819999, 1) == "Unknown");
+			CHECK(NameTable::GetLocationName(2365810001, 1) == "Dilapidated Dungeon - Dream Breaker");
+			CHECK(NameTable::HasNames(1));
+			CHECK(!NameTable::HasNames(2));
+			CHECK(NameTable::GetItemName(5, 2) == "Unknown");
+			// Players we don't know the game of have nothing coming, so they never hold anything up.
+			CHECK(NameTable::HasNames(9));
+
+			// Names stay attached to players that are set again after their game loaded.
+			NameTable::SetPlayers({ { 1, "Sybil (renamed)", "Pseudoregalia" } });
+			CHECK(NameTable::GetPlayerAlias(1) == "Sybil (renamed)");
+			CHECK(NameTable::GetItemName(2365810002, 1) == "Slide");
+
+			NameTable::Clear();
+			CHECK(NameTable::GetPlayerAlias(1) == "Unknown");
+			CHECK(NameTable::GetItemName(2365810001, 1) == "Unknown");
+
+			// Names for a game nobody loaded come out of the cache the first time a player of it is looked up.
+			json cached_package = {
+				{"games", {
+					{"Stand-in Game", {
+						{"checksum", "89abcdef0123456789abcdef0123456789abcdef"},
+						{"item_name_to_id", {{"Thing", 5}}},
+						{"location_name_to_id", {{"Place", 6}}},
+					}},
+					{"Corrupt Game", {
+						{"checksum", "fedcba9876543210fedcba9876543210fedcba98"},
+						{"item_name_to_id", {{"Broken Thing", 7}}},
+						{"location_name_to_id", json::object()},
+					}},
+					{"Missing Game", {
+						{"checksum", "00112233445566778899aabbccddeeff00112233"},
+						{"item_name_to_id", {{"Lost Thing", 8}}},
+						{"location_name_to_id", json::object()},
+					}},
+				}},
+			};
+			DataPackageCache::Save(cached_package);
+			const fs::path cache_directory("Mods/AP_Randomizer/dlls/datapackage");
+
+			// A game whose file is gone gets no stand-in, so the client fetches it like any other.
+			fs::remove(cache_directory / "00112233445566778899aabbccddeeff00112233.msgpack");
+			CHECK(DataPackageCache::LoadChecksums()["games"].size() == 2);
+
+			NameTable::SetPlayers({
+				{ 1, "Sybil", "Pseudoregalia" },
+				{ 2, "Other", "Stand-in Game" },
+				{ 3, "Someone", "Corrupt Game" },
+				});
+			CHECK(NameTable::HasNames(2));
+			CHECK(NameTable::GetItemName(5, 2) == "Thing");
+			CHECK(NameTable::GetLocationName(6, 2) == "Place");
+			CHECK(!NameTable::HasNames(1));
+			CHECK(NameTable::TakeGamesToFetch().empty());
+
+			// A stand-in was already handed out for an unreadable game, so it's dropped from the index and asked for once.
+			{
+				std::ofstream corrupt(cache_directory / "fedcba9876543210fedcba9876543210fedcba98.msgpack", std::ios::binary | std::ios::trunc);
+				corrupt << '\xc1';
+			}
+			CHECK(!NameTable::HasNames(3));
+			CHECK((NameTable::TakeGamesToFetch() == vector<string>{ "Corrupt Game" }));
+			CHECK(!NameTable::HasNames(3));
+			CHECK(NameTable::TakeGamesToFetch().empty());
+			json package;
+			CHECK(DataPackageCache::LoadGame("Corrupt Game", package) == DataPackageCache::LoadResult::NotCached);
+			CHECK(DataPackageCache::LoadChecksums()["games"].size() == 1);
+
+			NameTable::Clear();
+			fs::remove_all(cache_directory);
+		}
+
+		void TestAppendWide() {
+			auto append = [](const string& input) {
+				wstring output = L"> ";
+				StringOps::AppendWide(output, input);
+				return output;
+				};
+			const wchar_t replacement = 0xFFFD;
+
+			CHECK(append("Dream Breaker") == L"> Dream Breaker");
+			CHECK(append("\xC3\xA9") == (wstring(L"> ") + wchar_t(0xE9)));
+			CHECK(append("\xE2\x82\xAC") == (wstring(L"> ") + wchar_t(0x20AC)));
+			// Anything past the BMP becomes a surrogate pair, whatever the size of wchar_t.
+			CHECK(append("\xF0\x9F\x98\x80") == (wstring(L"> ") + wchar_t(0xD83D) + wchar_t(0xDE00)));
+			CHECK(append("\xF4\x8F\xBF\xBF") == (wstring(L"> ") + wchar_t(0xDBFF) + wchar_t(0xDFFF)));
+
+			// A bad lead is replaced on its own, and its continuation bytes are each replaced as strays.
+			CHECK(append("\xC0\xAF") == L"> " + wstring(2, replacement));
+			CHECK(append("\xE0\x80\xAF") == L"> " + wstring(3, replacement));
+			CHECK(append("\xED\xA0\x80") == L"> " + wstring(3, replacement));
+			CHECK(append("\xF4\x90\x80\x80") == L"> " + wstring(4, replacement));
+			CHECK(append("\xF5\x80\x80\x80") == L"> " + wstring(4, replacement));
+			CHECK(append("\xF8") == L"> " + wstring(1, replacement));
+			CHECK(append("a\xE2\x82") == L"> a" + wstring(2, replacement));
+			CHECK(append("\xE2\x82" "b") == L"> " + wstring(2, replacement) + L"b");
+		}
+
+		void TestSlotData() {
+			json slot_data = {
+				{"slot_number", 2},
+				{"death_link", true},
+				{"logic_level", 3},
+				{"obscure_logic", false},
+				{"progressive_breaker", true},
+				{"progressive_slide", false},
+				{"split_sun_greaves", true},
+				{"option_from_a_newer_apworld", "ignored"},
+			};
+			GameData::Options options;
+			CHECK(SlotData::Parse(slot_data, options));
+			CHECK(options.slot_number == 2);
+			CHECK(options.death_link);
+			CHECK(options.logic_level == 3);
+			CHECK(!options.obscure_logic);
+			CHECK(options.progressive_breaker);
+			CHECK(!options.progressive_slide);
+			CHECK(options.split_sun_greaves);
+
+			// Invalid slot data fails validation but still yields as many options as can be read.
+			json missing = slot_data;
+			missing.erase("death_link");
+			missing["progressive_slide"] = 1;
+			options = {};
+			CHECK(!SlotData::Parse(missing, options));
+			CHECK(!options.death_link);
+			CHECK(options.progressive_slide);
+			CHECK(options.logic_level == 3);
+
+			json out_of_range = slot_data;
+			out_of_range["logic_level"] = 5;
+			CHECK(!SlotData::Parse(out_of_range, options));
+
+			json wrong_type = slot_data;
+			wrong_type["logic_level"] = "2";
+			options = {};
+			CHECK(!SlotData::Parse(wrong_type, options));
+			CHECK(options.logic_level == GameData::Options().logic_level);
+		}
+
+		void TestOutboundQueue() {
+			using OutboundQueue::Priority;
+			OutboundQueue::Clear();
+			// Every push and run is given a time, so refills don't depend on how fast the test runs.
+			auto start = steady_clock::now();
+
+			// Higher priorities go first no matter when they were queued.
+			vector<int> order;
+			OutboundQueue::Push(Priority::Storage, [&order]() { order.push_back(3); }, start);
+			OutboundQueue::Push(Priority::Chat, [&order]() { order.push_back(2); }, start);
+			OutboundQueue::Push(Priority::Game, [&order]() { order.push_back(1); }, start);
+			OutboundQueue::Run(start);
+			CHECK((order == vector<int>{ 1, 2, 3 }));
+
+			// Storage starts with a full bucket of five tokens and refills at five a second.
+			// It spent one above, and no time has passed since.
+			int sent = 0;
+			for (int i = 0; i < 10; i++) {
+				OutboundQueue::Push(Priority::Storage, [&sent]() { sent++; }, start);
+			}
+			OutboundQueue::Run(start);
+			CHECK(sent == 4);
+			OutboundQueue::Run(start);
+			CHECK(sent == 4);
+			// 450ms refills two and a quarter tokens.
+			OutboundQueue::Run(start + milliseconds(450));
+			CHECK(sent == 6);
+			OutboundQueue::Stats stats = OutboundQueue::GetStats(Priority::Storage);
+			CHECK(stats.depth == 4);
+			CHECK(stats.sent == 7);
+			CHECK(stats.max_wait == milliseconds(450));
+
+			// A call is free to queue another one, since the lock isn't held while it runs.
+			bool nested = false;
+			OutboundQueue::Clear();
+			auto later = start + milliseconds(1000);
+			OutboundQueue::Push(Priority::Game, [&nested, later]() {
+				OutboundQueue::Push(Priority::Game, [&nested]() { nested = true; }, later);
+				}, later);
+			OutboundQueue::Run(later);
+			CHECK(nested);
+
+			// A full class drops new calls instead of growing.
+			OutboundQueue::Clear();
+			bool accepted = true;
+			for (int i = 0; i < 64; i++) {
+				accepted = OutboundQueue::Push(Priority::Chat, []() {}, later) && accepted;
+			}
+			CHECK(accepted);
+			CHECK(!OutboundQueue::Push(Priority::Chat, []() {}, later));
+			CHECK(OutboundQueue::GetStats(Priority::Chat).dropped == 1);
+			OutboundQueue::Clear();
+			CHECK(OutboundQueue::GetStats(Priority::Chat).depth == 0);
+		}
+
+		void TestClockSync() {
+			ClockSync::Reset();
+			CHECK(!ClockSync::GetEstimate().synced);
+			CHECK(Near(ClockSync::ServerNow(), WallClockSeconds(), 0.5));
+
+			// Room info alone is taken at face value.
+			ClockSync::OnRoomInfo(WallClockSeconds() + 100.0);
+			ClockSync::Estimate estimate = ClockSync::GetEstimate();
+			CHECK(estimate.synced);
+			CHECK(Near(estimate.offset_seconds, 100.0, 0.5));
+			CHECK(Near(ClockSync::ServerNow(), WallClockSeconds() + 100.0, 0.5));
+
+			// The first round trip corrects for the half of it that passed before room info arrived.
+			double before = estimate.offset_seconds;
+			ClockSync::OnRoundTrip(milliseconds(400));
+			estimate = ClockSync::GetEstimate();
+			CHECK(Near(estimate.offset_seconds, before + 0.2, 0.001));
+			CHECK(estimate.min_round_trip == milliseconds(400));
+
+			// A slower round trip is more likely to be queueing than distance, so it's ignored.
+			ClockSync::OnRoundTrip(milliseconds(800));
+			CHECK(Near(ClockSync::GetEstimate().offset_seconds, before + 0.2, 0.001));
+			CHECK(ClockSync::GetEstimate().jitter == microseconds(400000 / 16));
+
+			ClockSync::OnRoundTrip(milliseconds(100));
+			estimate = ClockSync::GetEstimate();
+			CHECK(Near(estimate.offset_seconds, before + 0.05, 0.001));
+			CHECK(estimate.min_round_trip == milliseconds(100));
+
+			ClockSync::Reset();
+			CHECK(!ClockSync::GetEstimate().synced);
+			CHECK(Near(ClockSync::ServerNow(), WallClockSeconds(), 0.5));
+		}
+
+		void TestMessageCoalescer() {
+			MessageCoalescer::Reset();
+			MessageCoalescer::SetWindow(milliseconds(100));
+			auto start = steady_clock::now();
+
+			// The first send of a run prints; the rest of the window folds into it.
+			CHECK(!MessageCoalescer::Fold(3, start));
+			CHECK(MessageCoalescer::Fold(3, start + milliseconds(10)));
+			CHECK(MessageCoalescer::Fold(3, start + milliseconds(99)));
+			CHECK(!MessageCoalescer::Fold(4, start + milliseconds(50)));
+			CHECK(MessageCoalescer::TakeClosedRuns(false, start + milliseconds(99)).empty());
+
+			// Runs that never folded anything close without a summary.
+			vector<MessageCoalescer::Summary> summaries = MessageCoalescer::TakeClosedRuns(false, start + milliseconds(100));
+			CHECK(summaries.size() == 1);
+			CHECK(!summaries.empty() && summaries[0].sender == 3 && summaries[0].folded == 2);
+			summaries = MessageCoalescer::TakeClosedRuns(false, start + milliseconds(150));
+			CHECK(summaries.empty());
+			CHECK(MessageCoalescer::TakeClosedRuns(true, start + milliseconds(150)).empty());
+
+			// The window is fixed from the first send, so a long burst starts a new run once it passes.
+			auto burst = start + milliseconds(200);
+			CHECK(!MessageCoalescer::Fold(5, burst));
+			CHECK(MessageCoalescer::Fold(5, burst + milliseconds(60)));
+			CHECK(!MessageCoalescer::Fold(5, burst + milliseconds(120)));
+			summaries = MessageCoalescer::TakeClosedRuns(false, burst + milliseconds(120));
+			CHECK(summaries.size() == 1 && summaries[0].folded == 1);
+			CHECK(MessageCoalescer::Fold(5, burst + milliseconds(180)));
+			summaries = MessageCoalescer::TakeClosedRuns(true, burst + milliseconds(180));
+			CHECK(summaries.size() == 1 && summaries[0].folded == 1);
+
+			MessageCoalescer::Stats stats = MessageCoalescer::GetStats();
+			CHECK(stats.folded == 4);
+			CHECK(stats.summaries == 3);
+
+			MessageCoalescer::SetWindow(milliseconds(0));
+			CHECK(!MessageCoalescer::Fold(3, start));
+			CHECK(!MessageCoalescer::Fold(3, start));
+			MessageCoalescer::SetWindow(milliseconds(2000));
+			MessageCoalescer::Reset();
+		}
+
+		void TestMpscQueue() {
+			Engine::MpscQueue<int, 4> queue;
+			for (int i = 0; i < 4; i++) {
+				CHECK(queue.TryPush([i](int& slot) { slot = i; }));
+			}
+			CHECK(!queue.TryPush([](int&) {}));
+			int value = -1;
+			CHECK(queue.TryPop([&value](int& slot) { value = slot; }) && value == 0);
+			CHECK(queue.TryPush([](int& slot) { slot = 4; }));
+			for (int i = 1; i <= 4; i++) {
+				CHECK(queue.TryPop([&value](int& slot) { value = slot; }) && value == i);
+			}
+			CHECK(!queue.TryPop([](int&) {}));
+
+			// Producers race each other, so only each producer's own values have to come out in order.
+			struct Tagged {
+				int producer;
+				int sequence;
+			};
+			const int producer_count = 4;
+			const int per_producer = 50000;
+			Engine::MpscQueue<Tagged, 64> shared;
+			vector<std::thread> producers;
+			for (int p = 0; p < producer_count; p++) {
+				producers.emplace_back([&shared, p]() {
+					for (int i = 0; i < per_producer; i++) {
+						while (!shared.TryPush([p, i](Tagged& slot) { slot = Tagged{ p, i }; })) {
+							std::this_thread::yield();
+						}
+					}
+					});
+			}
+			vector<int> next(producer_count, 0);
+			int popped = 0;
+			bool in_order = true;
+			while (popped < producer_count * per_producer) {
+				shared.TryPop([&](Tagged& slot) {
+					in_order = in_order && slot.sequence == next[slot.producer];
+					next[slot.producer]++;
+					popped++;
+					});
+			}
+			for (std::thread& producer : producers) {
+				producer.join();
+			}
+			CHECK(in_order);
+			CHECK(!shared.TryPop([](Tagged&) {}));
+		}
+
+		vector<int64_t> TakePendingChecks() {
+			std::list<int64_t> batch = Outbox::TakePendingChecks();
+			return vector<int64_t>(batch.begin(), batch.end());
+		}
+
+		double WallClockSeconds() {
+			auto now = std::chrono::system_clock::now().time_since_epoch();
+			return std::chrono::duration_cast<microseconds>(now).count() / 1000000.0;
+		}
+
+		bool Near(double value, double expected, double tolerance) {
+			return std::abs(value - expected) <= tolerance;
+		}
+	} // End private functions
+}
+
+int main() {
+	return UnitTests::Run();
+}
\ No newline at end of file